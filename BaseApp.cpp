@@ -77,6 +77,32 @@ BaseApp::~BaseApp()
   {
     delete pBufferedHTTPRestStream;
   }
+#ifdef RTC_LOG_TAIL
+  if (pRtcLogTail != nullptr)
+  {
+    delete pRtcLogTail;
+  }
+#endif
+#ifdef HTTP_LOG_SPILL
+  if (pLogSpillQueue != nullptr)
+  {
+    delete pLogSpillQueue;
+  }
+#endif
+#endif
+
+#ifdef CONSOLE_TCP
+  if (pTcpLogStream != nullptr)
+  {
+    delete pTcpLogStream;
+  }
+#endif
+
+#ifdef CONSOLE_SYSLOG
+  if (pSyslogStream != nullptr)
+  {
+    delete pSyslogStream;
+  }
 #endif
 }
 
@@ -98,7 +124,19 @@ void BaseApp::AppFirmwareVersion()
 void BaseApp::timeoutCallback()
 {
   // This sleep happened because of timeout. Do a restart after a sleep
-  console.log(Console::CRITICAL, F("Watchdog timeout...restarting"));
+  // Runs in loop context: either a failed setup step or loop() picking up watchdogExpired
+  // The fallback must not sleep or restart in the middle of the flush below
+  watchdog.detach();
+  watchdogFallback.detach();
+  CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::CRITICAL, "Watchdog timeout...restarting");
+#ifdef CONSOLE_HTTP
+  suspendHttpLog();
+#endif
+#ifdef CONSOLE_TCP
+  // no RTC tail: unsent TCP log lines are dropped rather than waited for
+  if (pTcpLogStream != nullptr)
+    pTcpLogStream->setSuspended(true);
+#endif
   console.flush();
 
 #ifdef DEEP_SLEEP_SECONDS
@@ -116,6 +154,41 @@ void BaseApp::timeoutCallback()
 #endif
 }
 
+// Loop context: loop() and each blocking setup step check the flag set by the
+// watchdog Ticker, so an expiry during setup is acted on before the fallback fires.
+void BaseApp::checkWatchdog()
+{
+  if (watchdogExpired)
+    timeoutCallback();
+}
+
+// Ticker context: no console output or sink I/O here, loop() handles the flag.
+// The fallback ticker catches a setup or loop that never gets back to check it.
+void BaseApp::watchdogCallback()
+{
+  watchdogExpired = true;
+  watchdogFallback.once(WATCHDOG_FALLBACK_SECONDS, [this]()
+                        { watchdogFallbackCallback(); });
+}
+
+// Ticker context, last resort: sleep or restart without logging. Unsent HTTP log
+// lines stay in the RTC tail and are replayed after the wakeup.
+void BaseApp::watchdogFallbackCallback()
+{
+#ifdef CONSOLE_HTTP
+  suspendHttpLog();
+#endif
+#ifdef CONSOLE_TCP
+  if (pTcpLogStream != nullptr)
+    pTcpLogStream->setSuspended(true);
+#endif
+#ifdef DEEP_SLEEP_SECONDS
+  enterDeepSleep(DEEP_SLEEP_SECONDS * 1000000, WAKE_RF_DEFAULT);
+#else
+  ESP.restart();
+#endif
+}
+
 #ifdef LED_STATUS_FLASH
 void BaseApp::flash()
 {
@@ -149,7 +222,7 @@ void BaseApp::setupNtp()
   const unsigned long timeout = 30000; // 30 seconds timeout
   const unsigned long start = millis();
    
-  while (!ntp_set && (millis() - start < timeout)) {
+  while (!ntp_set && !watchdogExpired && (millis() - start < timeout)) {
     delay(100);
     yield(); // Let the ESP8266 handle background tasks
   }
@@ -158,6 +231,8 @@ void BaseApp::setupNtp()
 void BaseApp::time_is_set(boolean from_sntp /* <= this optional parameter can be used with ESP8266 Core 3.0.0*/)
 {
   ntp_set = true;
+  // SDK callback context: deferred, written by the next loop()
+  console.logDeferred(Console::DEBUG, F("Time set (from_sntp=%d)"), from_sntp);
 }
 
 uint32_t BaseApp::sntp_startup_delay_MS_rfc_not_less_than_60000()
@@ -178,9 +253,9 @@ void BaseApp::setupMDNS() {
   const char* mDNSHostname = getMDNSHostname();
   mDNSHostname = config.get("mDNSHostname", mDNSHostname);
   if (MDNS.begin(mDNSHostname)) {  // Initialize mDNS with the hostname
-    console.log(Console::INFO, F("Advertising mDNS with hostname='%s.local'"), mDNSHostname);
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Advertising mDNS with hostname='%s.local'", mDNSHostname);
   } else {
-    console.log(Console::ERROR, F("Advertising mDNS with hostname='%s.local' failed"), mDNSHostname);
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::ERROR, "Advertising mDNS with hostname='%s.local' failed", mDNSHostname);
   }
 }
 #endif
@@ -202,22 +277,22 @@ void BaseApp::setupArduinoOta()
   ArduinoOTA.onStart([this]()
                      {
       watchdog.detach();
-      console.log(Console::INFO, F("OTA upload starting...")); });
+      CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "OTA upload starting..."); });
   ArduinoOTA.onEnd([this]()
-                   { console.log(Console::INFO, F("OTA upload finished")); });
+                   { CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "OTA upload finished"); });
   ArduinoOTA.onProgress([this](unsigned int progress, unsigned int total)
-                        { console.log(Console::INFO, F("Progress: %u%%"), (progress / (total / 100))); });
+                        { CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Progress: %u%%", (progress / (total / 100))); });
   ArduinoOTA.onError([this](ota_error_t error)
                      {
-      console.log(Console::ERROR, F("Error[%u]: "), error);
-      if (error == OTA_AUTH_ERROR) console.log(Console::ERROR, F("Auth Failed"));
-      else if (error == OTA_BEGIN_ERROR) console.log(Console::ERROR, F("Begin Failed"));
-      else if (error == OTA_CONNECT_ERROR) console.log(Console::ERROR, F("Connect Failed"));
-      else if (error == OTA_RECEIVE_ERROR) console.log(Console::ERROR, F("Receive Failed"));
-      else if (error == OTA_END_ERROR) console.log(Console::ERROR, F("End Failed")); });
+      CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::ERROR, "Error[%u]: ", error);
+      if (error == OTA_AUTH_ERROR) CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::ERROR, "Auth Failed");
+      else if (error == OTA_BEGIN_ERROR) CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::ERROR, "Begin Failed");
+      else if (error == OTA_CONNECT_ERROR) CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::ERROR, "Connect Failed");
+      else if (error == OTA_RECEIVE_ERROR) CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::ERROR, "Receive Failed");
+      else if (error == OTA_END_ERROR) CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::ERROR, "End Failed"); });
 
   ArduinoOTA.begin();
-  console.log(Console::INFO, F("Started Arduino OTA Server on port: %d"), port);
+  CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Started Arduino OTA Server on port: %d", port);
 }
 #endif
 
@@ -226,14 +301,14 @@ boolean BaseApp::performHttpOtaUpdate()
 {
   String http_ota_url = config.get("http_ota_url", HTTP_OTA_URL);
   if (http_ota_url.isEmpty()) {
-    console.log(Console::WARNING, F("No HTTP OTA URL configured"));
+    CONSOLE_LOG(console, Console::MODULE_HTTP, Console::WARNING, "No HTTP OTA URL configured");
     return false;
   }
 
   String http_ota_username = config.get("http_ota_username", HTTP_OTA_USERNAME);
   String http_ota_password = config.get("http_ota_password", HTTP_OTA_PASSWORD);
 
-  console.log(Console::INFO, F("Checking for firmware update via HTTP from %s"), http_ota_url.c_str());
+  CONSOLE_LOG(console, Console::MODULE_HTTP, Console::INFO, "Checking for firmware update via HTTP from %s", http_ota_url.c_str());
   
   // Set up HTTP update
   ESPhttpUpdate.rebootOnUpdate(true);
@@ -260,20 +335,20 @@ boolean BaseApp::performHttpOtaUpdate()
   // Handle the result
   switch (ret) {
     case HTTP_UPDATE_FAILED:
-      console.log(Console::ERROR, F("Firmware update failed: %s"), 
+      CONSOLE_LOG(console, Console::MODULE_HTTP, Console::ERROR, "Firmware update failed: %s", 
                 ESPhttpUpdate.getLastErrorString().c_str());
       return false;
       
     case HTTP_UPDATE_NO_UPDATES:
-      console.log(Console::INFO, F("No firmware update available"));
+      CONSOLE_LOG(console, Console::MODULE_HTTP, Console::INFO, "No firmware update available");
       return false;
       
     case HTTP_UPDATE_OK:
-      console.log(Console::INFO, F("Firmware update successful"));
+      CONSOLE_LOG(console, Console::MODULE_HTTP, Console::INFO, "Firmware update successful");
       return true;
       
     default:
-      console.log(Console::ERROR, F("Unknown firmware update status: %d"), ret);
+      CONSOLE_LOG(console, Console::MODULE_HTTP, Console::ERROR, "Unknown firmware update status: %d", ret);
       return false;
   }
 }
@@ -289,24 +364,25 @@ boolean BaseApp::connectWiFi()
 
   // Watchdog timer - resets if setup takes longer than allocated time
   watchdog.once(WATCHDOG_SETUP_SECONDS, [this]()
-                { timeoutCallback(); });
+                { watchdogCallback(); });
 
   // try connect using previous connection details stored in eeprom
   if (WiFi.SSID().length() > 0)
   {
     // Print the SSID and password
-    console.log(Console::INFO, F("WiFi credentials stored: %s"), WiFi.SSID().c_str());
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "WiFi credentials stored: %s", WiFi.SSID().c_str());
 
-    console.log(Console::INFO, F("Connecting..."));
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Connecting...");
 
     WiFi.begin(WiFi.SSID(), WiFi.psk());
     WiFi.waitForConnectResult(FAST_CONNECTION_TIMEOUT);
+    checkWatchdog();
   }
 
 #ifdef WPS_CONFIG
   if (WiFi.status() != WL_CONNECTED)
   {
-    console.log(Console::INFO, F("Starting WPS configuration..."));
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Starting WPS configuration...");
     WiFi.beginWPSConfig();
 
     if (WiFi.SSID().length() > 0)
@@ -318,9 +394,10 @@ boolean BaseApp::connectWiFi()
       WiFi.persistent(true);
       WiFi.setAutoConnect(true);
       WiFi.setAutoReconnect(true);
+      checkWatchdog();
       if (WiFi.waitForConnectResult() != WL_CONNECTED)
       {
-        console.log(Console::WARNING, F("Connecting using WPS timed out!"));
+        CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::WARNING, "Connecting using WPS timed out!");
         timeoutCallback();
       }
     }
@@ -339,7 +416,7 @@ boolean BaseApp::connectWiFi()
       watchdog.detach();
       if (!wifiManager.startConfigPortal(SSID, NULL))
       {
-        console.log(Console::ERROR, F("Starting WiFi Config Portal Failed!"));
+        CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::ERROR, "Starting WiFi Config Portal Failed!");
         timeout_cb();
       }
     }
@@ -353,9 +430,11 @@ boolean BaseApp::connectWiFi()
       wifiManager.setConfigPortalTimeout(180);
       wifiManager.setAPCallback([this](WiFiManager *myWiFiManager)
                                 { configModeCallback(myWiFiManager); });
-      if (!wifiManager.autoConnect())
+      bool portalConnected = wifiManager.autoConnect();
+      checkWatchdog();
+      if (!portalConnected)
       {
-        console.log(Console::WARNING, F("Connection Failed!"));
+        CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::WARNING, "Connection Failed!");
         timeoutCallback();
       }
 
@@ -367,7 +446,7 @@ boolean BaseApp::connectWiFi()
     // Save boot up time by not configuring them if they haven't changed
     if (WiFi.SSID() != WIFI_SSID)
     {
-      console.log(Console::INFO, F("Initialising Wifi..."));
+      CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Initialising Wifi...");
       WiFi.mode(WIFI_STA);
       WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
       WiFi.persistent(true);
@@ -377,9 +456,11 @@ boolean BaseApp::connectWiFi()
 #endif
   }
 
-  if (WiFi.waitForConnectResult() != WL_CONNECTED)
+  bool connected = WiFi.waitForConnectResult() == WL_CONNECTED;
+  checkWatchdog();
+  if (!connected)
   {
-    console.log(Console::WARNING, F("Connection Finally Failed!"));
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::WARNING, "Connection Finally Failed!");
     timeoutCallback();
   }
 
@@ -391,7 +472,10 @@ boolean BaseApp::connectWiFi()
   if (WiFi.status() == WL_CONNECTED)
   {
     // we have internet connection
-    console.log(Console::INFO, F("IP address: %s"), WiFi.localIP().toString().c_str());
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "IP address: %s", WiFi.localIP().toString().c_str());
+    // auto reconnect brings the link back, loop() drops the kept connections
+    wifiDisconnectedHandler = WiFi.onStationModeDisconnected([this](const WiFiEventStationModeDisconnected &)
+                                                             { wifiDisconnected = true; });
     return true;
   }
   else
@@ -431,19 +515,35 @@ void BaseApp::setup()
   // try to initialize with baud rate from config
   int serial_baud = config.get("serial_baud", SERIAL_DEFAULT_BAUD);
   console.begin(serial_baud);
+  // Serial sink: own level and policy (see Console::SinkPolicy). The default flushes after
+  // each line as before the sinks existed, 0 (SINK_BLOCKING) opts out for faster logging
+  console.setSinkLevel(Serial, console.intToLogLevel(config.get("serial_log_level", Console::DEBUG)));
+  console.setSinkPolicy(Serial, config.get("serial_log_policy", Console::SINK_FLUSH_LINE));
 
    // determine logLevel
    int logLevel = config.get("log_level", Console::DEBUG);
    console.setLogLevel(console.intToLogLevel(logLevel));
+   // per module log levels e.g. "log_level_http" override "log_level"
+   for (int module = 0; module < Console::MODULE_COUNT; module++) {
+     char key[24];
+     snprintf(key, sizeof(key), "log_level_%s", Console::getModuleName((Console::LogModule)module));
+     if (config.exists(key)) {
+       console.setLogLevel((Console::LogModule)module, console.intToLogLevel(config.get(key, logLevel)));
+     }
+   }
    // set log time format
    if (config.exists("log_time_format")) {
      console.setTimeFormat(config.get("log_time_format", ""));
    }
+   console.setTimeMillis(config.get("log_time_millis", 0));
+   // collapse repeated lines and limit lines per call site e.g. OTA progress
+   console.setDeduplicate(config.get("log_dedup", 1));
+   console.setRateLimit(config.get("log_rate_limit", 0), config.get("log_rate_window_secs", 10) * 1000UL);
 
   console.println(); // newline after garbage from startup
 
 #ifdef GDB_DEBUG
-  console.log(Console::INFO, F("GDB Debug enabled"));
+  CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "GDB Debug enabled");
   gdbstub_init();
 #endif
 
@@ -457,6 +557,7 @@ void BaseApp::setup()
 
 #ifdef USE_NTP
   setupNtp();
+  checkWatchdog();
 #endif
 
   // Initialize the WiFi client manager with TLS public key from config
@@ -467,43 +568,155 @@ void BaseApp::setup()
   
 #ifdef CONSOLE_TELNET
   int port = config.get("telnet_port", TELNET_DEFAULT_PORT);
-  console.log(Console::INFO, F("Telnet service started on port: %d"), port);
-  pBufferedTelnetStream = new TelnetStreamBuffered(port);
+  CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Telnet service started on port: %d", port);
+  // output ring shared by all clients, a new client gets the lines still in it
+  pBufferedTelnetStream = new TelnetStreamBuffered(port, config.get("telnet_buffer_size", TELNET_BUFFER_SIZE));
   pBufferedTelnetStream->begin(port);
-  console.begin(*pBufferedTelnetStream, Serial); // continue output to Serial
+  console.addSink(*pBufferedTelnetStream, console.intToLogLevel(config.get("telnet_log_level", Console::DEBUG)), Console::SINK_BLOCKING, pBufferedTelnetStream);
+  console.setInputStream(*pBufferedTelnetStream); // output continues to Serial
 #else
 #ifdef CONSOLE_HTTP
   // int port = config.get("telnet_port", TELNET_DEFAULT_PORT);
-  // console.log(Console::INFO, F("Telnet service started on port: %d"), port);
+  // CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Telnet service started on port: %d", port);
   const char *http_log_url = config.get("http_log_url");
   if (!strlen(http_log_url))
   { // empty
-    console.log(Console::ERROR, F("Missing configuration for 'http_log_url'. HTTP logging not started."));
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::ERROR, "Missing configuration for 'http_log_url'. HTTP logging not started.");
   }
   else
   {
+    // raw bodies go to the /log/raw route next to the JSON /log route of http_log_url.
+    // Compression applies to the raw record payload only, so it implies raw mode.
+    bool http_log_compress = config.get("http_log_compress", 0);
+    bool http_log_raw = config.get("http_log_raw", 0) || http_log_compress;
     pBufferedHTTPRestStream = new HttpStreamBuffered(
       *ManageWifiClient::getClient(http_log_url),
       config.get("http_log_id", FIRMWARE_VERSION.c_str()), 
-      http_log_url, "",
+      http_log_url, http_log_raw ? "/raw" : "",
       config.get("http_log_username"),
       config.get("http_log_password")
     );
-    console.log(Console::INFO, F("Starting HTTP logging to %s."), http_log_url);
-    console.begin(*pBufferedHTTPRestStream, Serial);
+    pBufferedHTTPRestStream->setRaw(http_log_raw);
+    pBufferedHTTPRestStream->setCompress(http_log_compress);
+    // sending is done from loop(), never from within a log call
+    pBufferedHTTPRestStream->setFlushPolicy(
+      config.get("http_log_flush_bytes", CIRCULAR_BUFFER_SIZE * 3 / 4),
+      config.get("http_log_flush_age_ms", 5000));
+    httpLogSleepDrain = config.get("http_log_sleep_drain", 0);
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Starting HTTP logging to %s.", http_log_url);
+    uint8_t policy = Console::SINK_BLOCKING;
+    if (config.get("http_log_binary", 0)) {
+      // records are expanded by the log server using the firmware ELF
+      pBufferedHTTPRestStream->setBinary(true);
+      policy |= Console::SINK_RECORDS;
+    }
+#ifdef RTC_LOG_TAIL
+    size_t restored = 0;
+    if (config.get("http_log_rtc_tail", 1)) {
+      pRtcLogTail = new RtcLogBuffer(RTC_LOG_TAIL_OFFSET, RTC_LOG_TAIL_SIZE);
+      restored = pBufferedHTTPRestStream->setRtcTail(pRtcLogTail);
+    }
+#endif
+#ifdef HTTP_LOG_SPILL
+    // binary and text records must not be replayed into the other format
+    int spillSegments = config.get("http_log_spill_segments", 32);
+    if (spillSegments > 0) {
+      pLogSpillQueue = new LogSpillQueue((policy & Console::SINK_RECORDS) ? "/logq-bin" : "/logq", SPILL_SEGMENT_SIZE, spillSegments);
+      if (pLogSpillQueue->begin()) {
+        pBufferedHTTPRestStream->setSpillQueue(pLogSpillQueue);
+      }
+      else {
+        delete pLogSpillQueue;
+        pLogSpillQueue = nullptr;
+      }
+    }
+#endif
+    console.addSink(*pBufferedHTTPRestStream, console.intToLogLevel(config.get("http_log_level", Console::DEBUG)), policy, pBufferedHTTPRestStream);
+    // e.g. DEBUG/INFO only by syslog, acknowledged delivery for WARNING and above
+    console.setSinkMaxLevel(*pBufferedHTTPRestStream, console.intToLogLevel(config.get("http_log_max_level", Console::CRITICAL)));
+#ifdef RTC_LOG_TAIL
+    if (restored > 0) {
+      // ship the final lines of the previous run now: flush() sends the segments
+      // spilled to flash first, then the restored records
+      CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Restored %d log records kept in RTC memory before reset", restored);
+      pBufferedHTTPRestStream->flush();
+      checkWatchdog();
+    }
+#endif
+#ifdef HTTP_LOG_SPILL
+    if (pLogSpillQueue == nullptr) {
+      CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::WARNING, "HTTP log spill queue not available, log lines are dropped while offline");
+    }
+    else if (!pLogSpillQueue->isEmpty()) {
+      // replayed from loop() before newer lines
+      CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "%d log segments queued on flash before reset", pLogSpillQueue->segmentCount());
+    }
+#endif
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::DEBUG, "HTTP logging uses %s", (policy & Console::SINK_RECORDS) ? "binary records" : "text");
   }
 #endif
 #endif
 
+#ifdef CONSOLE_TCP
+  // one connection for the whole awake period, log id and credentials as for HTTP logging
+  const char *tcp_log_host = config.get("tcp_log_host");
+  if (!strlen(tcp_log_host))
+  { // empty
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::ERROR, "Missing configuration for 'tcp_log_host'. TCP logging not started.");
+  }
+  else
+  {
+    int port = config.get("tcp_log_port", TCP_LOG_DEFAULT_PORT);
+    pTcpLogStream = new TcpLogStream(
+      tcp_log_host, port,
+      config.get("http_log_id", FIRMWARE_VERSION.c_str()),
+      config.get("http_log_username"),
+      config.get("http_log_password")
+    );
+    uint8_t policy = Console::SINK_BLOCKING;
+    if (config.get("tcp_log_binary", 0)) {
+      pTcpLogStream->setBinary(true);
+      policy |= Console::SINK_RECORDS;
+    }
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Starting TCP logging to %s:%d.", tcp_log_host, port);
+    console.addSink(*pTcpLogStream, console.intToLogLevel(config.get("tcp_log_level", Console::DEBUG)), policy, pTcpLogStream);
+  }
+#endif
+
+#ifdef CONSOLE_SYSLOG
+  const char *syslog_host = config.get("syslog_host");
+  if (!strlen(syslog_host))
+  { // empty
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::ERROR, "Missing configuration for 'syslog_host'. Syslog not started.");
+  }
+  else
+  {
+    int port = config.get("syslog_port", SYSLOG_DEFAULT_PORT);
+    // the log id is the syslog APP-NAME, so the server app writes to the same log as for HTTP
+    pSyslogStream = new SyslogStream(
+      syslog_host, port,
+      getMDNSHostname(),
+      config.get("http_log_id", FIRMWARE_VERSION.c_str()),
+      // batching is non-standard, see SyslogStream.h: 0 for receivers other than the log server app
+      config.get("syslog_batch", 1)
+    );
+    pSyslogStream->setMaxDelay(config.get("syslog_max_delay_ms", 1000));
+    pSyslogStream->begin();
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Starting syslog to %s:%d.", syslog_host, port);
+    console.addSink(*pSyslogStream, console.intToLogLevel(config.get("syslog_level", Console::DEBUG)), Console::SINK_BLOCKING | Console::SINK_NO_PREFIX, pSyslogStream);
+    console.setSinkMaxLevel(*pSyslogStream, console.intToLogLevel(config.get("syslog_max_level", Console::CRITICAL)));
+  }
+#endif
+
   AppFirmwareVersion();
-  console.log(Console::INFO, F("Current firmware version: '%s'"), (FIRMWARE_VERSION).c_str());
+  CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Current firmware version: '%s'", (FIRMWARE_VERSION).c_str());
   logEnabledFeatures();
 
-  console.log(Console::INFO, F("Flash ID: 0x%06X, Deep Sleep Workaround: %s"), 
+  CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Flash ID: 0x%06X, Deep Sleep Workaround: %s", 
             (flashId & 0xFFFFFF), 
             deepSleepWorkaround ? "Enabled" : "Disabled");
 
-  console.log(Console::DEBUG, F("Start of initialization: Reset Reason='%s'"), getResetReasonString(ESP.getResetInfoPtr()->reason).c_str());
+  CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::DEBUG, "Start of initialization: Reset Reason='%s'", getResetReasonString(ESP.getResetInfoPtr()->reason).c_str());
 
   // Print config
   config.print(&console);
@@ -522,6 +735,7 @@ void BaseApp::setup()
 
 #ifdef HTTP_CONFIG
   config.performHttpConfigUpdate( FIRMWARE_VERSION, &console);
+  checkWatchdog();
 #endif  
 
 #ifdef HTTP_OTA
@@ -531,15 +745,16 @@ void BaseApp::setup()
 #ifdef DEEP_SLEEP_SECONDS
   if (!deepSleepState.loadFromRTC())
   {
-    console.log(Console::DEBUG, F("DeepSleepState cold boot - calling appDeepSleepStateInit for state initialization."));
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::DEBUG, "DeepSleepState cold boot - calling appDeepSleepStateInit for state initialization.");
     AppDeepSleepStateInit();
   }
 #endif
 
   // individual setup for apps
   AppSetup();
+  checkWatchdog();
 
-  console.log(Console::DEBUG, F("End of initialization"));
+  CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::DEBUG, "End of initialization");
   watchdog.detach();
 }
 
@@ -570,6 +785,19 @@ void BaseApp::AppNTPSet()
 
 void BaseApp::loop()
 {
+  // write log records queued from Ticker and callback contexts
+  console.drainDeferred(DEFERRED_LOG_BUDGET_MICROS);
+
+  // the watchdog expired during the previous iteration
+  checkWatchdog();
+
+  // the connections kept by JSONAPIClient did not survive the lost WiFi link:
+  // close them instead of failing the next request on a dead socket
+  if (wifiDisconnected)
+  {
+    wifiDisconnected = false;
+    JSONAPIClient::closeConnections();
+  }
 
 #ifdef USE_MDNS
   // Handle mDNS requests
@@ -596,7 +824,31 @@ void BaseApp::loop()
 
   // Watchdog timer - resets if setup takes longer than allocated time
   watchdog.once(WATCHDOG_LOOP_SECONDS, [this]()
-                { timeoutCallback(); });
+                { watchdogCallback(); });
+
+#ifdef CONSOLE_TELNET
+  // accept telnet clients and send them what they did not take yet
+  if (pBufferedTelnetStream != nullptr)
+    pBufferedTelnetStream->poll();
+#endif
+
+#ifdef CONSOLE_HTTP
+  // send buffered log lines when the watermark or maximum age is reached
+  if (pBufferedHTTPRestStream != nullptr)
+    pBufferedHTTPRestStream->poll();
+#endif
+
+#ifdef CONSOLE_TCP
+  // keep the log connection up and send what it did not take yet
+  if (pTcpLogStream != nullptr)
+    pTcpLogStream->poll();
+#endif
+
+#ifdef CONSOLE_SYSLOG
+  // resolve the host if that failed so far, send a batched datagram that waited long enough
+  if (pSyslogStream != nullptr)
+    pSyslogStream->poll();
+#endif
 
 #ifdef TIMER_INTERVAL_MILLIS
   // https://www.norwegiancreations.com/2018/10/arduino-tutorial-avoiding-the-overflow-issue-when-using-millis-and-micros/
@@ -624,12 +876,12 @@ void BaseApp::loop()
   if ((ESP.getResetInfoPtr()->reason == REASON_DEEP_SLEEP_AWAKE) || expired)
   {
     if (preventDeepSleep)
-      console.log(Console::DEBUG, F("Prevented from deep sleep: preventDeepSleep=%d"), preventDeepSleep);
+      CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::DEBUG, "Prevented from deep sleep: preventDeepSleep=%d", preventDeepSleep);
     else
     {
       // Enter DeepSleep
       deepSleepState.saveToRTC();
-      console.log(Console::INFO, F("Entering deep sleep for %d seconds..."), DEEP_SLEEP_SECONDS);
+      CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Entering deep sleep for %d seconds...", DEEP_SLEEP_SECONDS);
       digitalWrite(STATUS_LED, HIGH);
       deepSleep(DEEP_SLEEP_SECONDS * 1000000);
       // Do nothing while we wait for sleep to overcome us
@@ -647,59 +899,71 @@ void BaseApp::loop()
 void BaseApp::logEnabledFeatures() {
     // Check and log each 
     #ifdef WIFI_PORTAL
-    console.log(Console::INFO, F("Feature Enabled: WiFi Configuration Portal"));
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Feature Enabled: WiFi Configuration Portal");
     #endif
 
     #ifdef WPS_CONFIG
-    console.log(Console::INFO, F("Feature Enabled: WPS Configuration"));
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Feature Enabled: WPS Configuration");
     #endif
 
     #ifdef ARDUINO_OTA
-    console.log(Console::INFO, F("Feature Enabled: Arduino OTA Updates"));
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Feature Enabled: Arduino OTA Updates");
     #endif
 
     #ifdef HTTP_OTA
-    console.log(Console::INFO, F("Feature Enabled: HTTP OTA Updates"));
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Feature Enabled: HTTP OTA Updates");
     #endif
 
     #ifdef HTTP_CONFIG
-    console.log(Console::INFO, F("Feature Enabled: HTTP Config Updates"));
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Feature Enabled: HTTP Config Updates");
     #endif
 
     #ifdef LED_STATUS_FLASH
-    console.log(Console::INFO, F("Feature Enabled: LED Status Flash"));
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Feature Enabled: LED Status Flash");
     #endif
 
     #ifdef DEEP_SLEEP_SECONDS
-    console.log(Console::INFO, F("Feature Enabled: Deep Sleep Mode (Seconds: %d, Startup Seconds: %d)"), DEEP_SLEEP_SECONDS, DEEP_SLEEP_STARTUP_SECONDS);
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Feature Enabled: Deep Sleep Mode (Seconds: %d, Startup Seconds: %d)", DEEP_SLEEP_SECONDS, DEEP_SLEEP_STARTUP_SECONDS);
     #endif
 
     #ifdef JSON_CONFIG_OTA
-    console.log(Console::INFO, F("Feature Enabled: JSON Configuration OTA"));
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Feature Enabled: JSON Configuration OTA");
     #endif
 
     #ifdef GDB_DEBUG
-    console.log(Console::INFO, F("Feature Enabled: GDB Debugging"));
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Feature Enabled: GDB Debugging");
     #endif
 
     #ifdef USE_NTP
-    console.log(Console::INFO, F("Feature Enabled: NTP (Network Time Protocol)"));
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Feature Enabled: NTP (Network Time Protocol)");
     #endif
 
     #ifdef USE_MDNS
-    console.log(Console::INFO, F("Feature Enabled: mDNS (Local Network Hostname Resolution)"));
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Feature Enabled: mDNS (Local Network Hostname Resolution)");
     #endif
 
     #ifdef TIMER_INTERVAL_MILLIS
-    console.log(Console::INFO, F("Feature Enabled: Timer Interval Execution (ms: %d)"), TIMER_INTERVAL_MILLIS);
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Feature Enabled: Timer Interval Execution (ms: %d)", TIMER_INTERVAL_MILLIS);
     #endif
 
     #ifdef CONSOLE_TELNET
-    console.log(Console::INFO, F("Feature Enabled: Telnet Console Output"));
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Feature Enabled: Telnet Console Output");
     #endif
 
     #ifdef CONSOLE_HTTP
-    console.log(Console::INFO, F("Feature Enabled: HTTP Console Output"));
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Feature Enabled: HTTP Console Output");
+    #endif
+
+    #ifdef CONSOLE_TCP
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Feature Enabled: TCP Console Output");
+    #endif
+
+    #ifdef CONSOLE_SYSLOG
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Feature Enabled: Syslog Console Output");
+    #endif
+
+    #ifdef HTTP_LOG_SPILL
+    CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "Feature Enabled: HTTP Log Spill Queue");
     #endif
 }
 
@@ -738,18 +1002,66 @@ void BaseApp::deepSleepNK(uint32 time_us)
   __asm volatile("waiti 0");
 }
 
+#ifdef CONSOLE_HTTP
+// Sleeping or restarting must not wait on the network: unsent log lines stay in
+// the RTC log tail and are sent after the next wake. Without a tail they are
+// still posted by the following console.flush().
+void BaseApp::suspendHttpLog()
+{
+  if (pBufferedHTTPRestStream != nullptr && pBufferedHTTPRestStream->hasRtcTail())
+  {
+    pBufferedHTTPRestStream->setSuspended(true);
+  }
+}
+#endif
+
 void BaseApp::deepSleep(uint32_t time_us, RFMode mode) {
+#ifdef CONSOLE_HTTP
+    // explicit pre-sleep drain by console.flush() if configured
+    if (!httpLogSleepDrain)
+      suspendHttpLog();
+    if (pBufferedHTTPRestStream != nullptr && pBufferedHTTPRestStream->getCompressSkipped() > 0) {
+      CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "HTTP log: %u batches sent uncompressed for lack of heap",
+        pBufferedHTTPRestStream->getCompressSkipped());
+    }
+#ifdef HTTP_LOG_SPILL
+    if (pLogSpillQueue != nullptr && (pLogSpillQueue->getSpilledBytes() > 0 || pLogSpillQueue->getEvictedBytes() > 0)) {
+      CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::INFO, "HTTP log spill: %u bytes spilled, %u replayed, %u evicted",
+        pLogSpillQueue->getSpilledBytes(), pLogSpillQueue->getReplayedBytes(), pLogSpillQueue->getEvictedBytes());
+    }
+#endif
+#endif
+#ifdef CONSOLE_TCP
+    // an open connection takes the last lines, a lost one is not re-established for them
+    if (pTcpLogStream != nullptr && !pTcpLogStream->connected())
+      pTcpLogStream->setSuspended(true);
+#endif
+    if (deepSleepWorkaround) {
+        CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::DEBUG, "Using deep sleep workaround for this zombie flash chip for %d us with RF mode %d", time_us, mode);
+    } else {
+        CONSOLE_LOG(console, Console::MODULE_BASEAPP, Console::DEBUG, "Using deep sleep for %d us with RF mode %d", time_us, mode);
+    }
+    console.flush();
+    // end the kept connections cleanly rather than leaving them to the server's idle timeout
+    JSONAPIClient::closeConnections();
+    enterDeepSleep(time_us, mode);
+}
+
+// Enter deep sleep without any console output, safe to call from Ticker context.
+// Kept connections are not closed here: no TCP calls from Ticker context.
+void BaseApp::enterDeepSleep(uint32_t time_us, RFMode mode) {
+#ifdef CONSOLE_HTTP
+    // the log lines not sent before sleeping are shipped after the wake
+    if (pBufferedHTTPRestStream != nullptr)
+        pBufferedHTTPRestStream->saveRtcTail();
+#endif
     if (deepSleepWorkaround) {
         // For the workaround, we need to set the deep sleep option manually
         system_deep_sleep_set_option(mode);
         // Use the workaround method for problematic flash chips
-        console.log(Console::DEBUG, F("Using deep sleep workaround for this zombie flash chip for %d us with RF mode %d"), time_us, mode);
-        console.flush();
         deepSleepNK(time_us);
     } else {
         // Use standard deep sleep for known good chips
-        console.log(Console::DEBUG, F("Using deep sleep for %d us with RF mode %d"), time_us, mode);
-        console.flush();
         ESP.deepSleep(time_us, mode);
     }
 }
\ No newline at end of file
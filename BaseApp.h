@@ -36,6 +36,14 @@ namespace BearSSL { class PublicKey; }
 #include "HttpStreamBuffered.h"
 #endif
 
+#ifdef CONSOLE_TCP
+#include "TcpLogStream.h"
+#endif
+
+#ifdef CONSOLE_SYSLOG
+#include "SyslogStream.h"
+#endif
+
 #ifdef HTTP_CONFIG
 #include "JSONAPIClient.h"
 #endif
@@ -91,7 +99,13 @@ protected:
   String FIRMWARE_VERSION = String(__FILE__) + "-" + String(__DATE__) + "-" + String(__TIME__);
   const uint8 WATCHDOG_SETUP_SECONDS = 60; // Setup should complete well within this time limit
   const uint8 WATCHDOG_LOOP_SECONDS = 40;  // Loop should complete well within this time limit
+  const uint8 WATCHDOG_FALLBACK_SECONDS = 20; // Grace time for loop() to handle an expired watchdog
+  const uint32_t DEFERRED_LOG_BUDGET_MICROS = 2000; // time per loop for writing deferred log records
   Ticker watchdog;
+  Ticker watchdogFallback;
+  volatile bool watchdogExpired = false; // set in Ticker context, handled in loop()
+  WiFiEventHandler wifiDisconnectedHandler;
+  volatile bool wifiDisconnected = false; // set by the WiFi event, handled in loop()
 
   Console console;
   Config config;
@@ -105,10 +119,14 @@ protected:
 
   String getResetReasonString(uint8_t reason);
   void timeoutCallback();
+  void checkWatchdog();
+  void watchdogCallback();
+  void watchdogFallbackCallback();
   bool connectWiFi();
   void logEnabledFeatures();
 
   void deepSleep(uint32_t time_us, RFMode mode = RF_DEFAULT);
+  void enterDeepSleep(uint32_t time_us, RFMode mode = RF_DEFAULT);
   
 #ifdef USE_MDNS
   void setupMDNS();
@@ -130,6 +148,27 @@ protected:
 
 #ifdef CONSOLE_HTTP
   HttpStreamBuffered *pBufferedHTTPRestStream = nullptr;
+  bool httpLogSleepDrain = false; // send pending log lines before deep sleep instead of keeping them
+  void suspendHttpLog();
+#ifdef RTC_LOG_TAIL
+  // RTC user memory blocks 64..127, the lower half is left to RTCVars and eboot
+  const uint32_t RTC_LOG_TAIL_OFFSET = 64;
+  const size_t RTC_LOG_TAIL_SIZE = 256;
+  RtcLogBuffer *pRtcLogTail = nullptr;
+#endif
+#ifdef HTTP_LOG_SPILL
+  LogSpillQueue *pLogSpillQueue = nullptr;
+#endif
+#endif
+
+#ifdef CONSOLE_TCP
+  const int TCP_LOG_DEFAULT_PORT = 8082;
+  TcpLogStream *pTcpLogStream = nullptr;
+#endif
+
+#ifdef CONSOLE_SYSLOG
+  const int SYSLOG_DEFAULT_PORT = 514;
+  SyslogStream *pSyslogStream = nullptr;
 #endif
 
 #ifdef ARDUINO_OTA
@@ -12,6 +12,16 @@ Config::Config() : configJsonDoc(JSON_CONFIG_MAXSIZE), server(JSON_CONFIG_OTA_PO
     retrieveJSON();
 }
 
+Config::~Config()
+{
+#ifdef HTTP_CONFIG
+  if (httpConfigRequest != nullptr)
+  {
+    delete httpConfigRequest;
+  }
+#endif // HTTP_CONFIG
+}
+
 bool Config::retrieveJSON()
 {
   File file = LittleFS.open(JSON_CONFIG_OTA_FILE, "r");
@@ -93,7 +103,7 @@ void Config::handleOTAServerRequest()
         if (saveConfig(configDoc)) {
           // Log the incoming request
           if (refConsole != nullptr) {
-            refConsole->log(Console::INFO, F("OTA Config update received from IP: %s"), server.client().remoteIP().toString().c_str());
+            CONSOLE_LOG(*refConsole, Console::MODULE_CONFIG, Console::INFO, "OTA Config update received from IP: %s", server.client().remoteIP().toString().c_str());
           }
           
           server.send(200);
@@ -129,7 +139,7 @@ void Config::setupOtaServer(Console *console)
   int port = get("json_config_ota_port", JSON_CONFIG_OTA_PORT);
   server.begin(port);
   if (refConsole != nullptr) {
-    refConsole->log(Console::INFO, F("Config OTA Server started on port: %d"), port);
+    CONSOLE_LOG(*refConsole, Console::MODULE_CONFIG, Console::INFO, "Config OTA Server started on port: %d", port);
   }
 }
 
@@ -178,7 +188,7 @@ bool Config::performHttpConfigUpdate(const String& firmwareVersion, Console* con
   String http_config_url = get("http_config_url", HTTP_CONFIG_URL);
   if (http_config_url.isEmpty()) {
     if (console) {
-      console->log(Console::WARNING, F("No HTTP config URL configured"));
+      CONSOLE_LOG(*console, Console::MODULE_HTTP, Console::WARNING, "No HTTP config URL configured");
     }
     return false;
   }
@@ -187,16 +197,22 @@ bool Config::performHttpConfigUpdate(const String& firmwareVersion, Console* con
   String http_config_password = get("http_config_password", HTTP_CONFIG_PASSWORD);
 
   if (console) {
-    console->log(Console::INFO, F("Checking for config update via HTTP from %s"), http_config_url.c_str());
+    CONSOLE_LOG(*console, Console::MODULE_HTTP, Console::INFO, "Checking for config update via HTTP from %s", http_config_url.c_str());
   }
 
-  // Allocate JSON documents for request and response
-  DynamicJsonDocument requestHeader(256);  // Headers with version info and last_updated
+  // rebuilt when an update brought another URL
+  if (httpConfigRequest != nullptr && httpConfigRequest->getUrl() != http_config_url) {
+    delete httpConfigRequest;
+    httpConfigRequest = nullptr;
+  }
+  if (httpConfigRequest == nullptr) {
+    httpConfigRequest = new PreparedRequest(http_config_url.c_str(), "", http_config_username.c_str(), http_config_password.c_str());
+  }
   DynamicJsonDocument requestBody(0);      // Empty body for GET request
-  
-  // Add version header
-  requestHeader["x-ESP8266-version"] = firmwareVersion;
-  requestHeader["x-ESP8266-config-version"] = get("version", "");
+
+  // Version headers, the config version changes with each update
+  httpConfigRequest->setHeader("x-ESP8266-version", firmwareVersion.c_str());
+  httpConfigRequest->setHeader("x-ESP8266-config-version", get("version", ""));
 
   // To free current memory and recreate with full capacity
   configJsonDoc = DynamicJsonDocument(JSON_CONFIG_MAXSIZE);
@@ -205,13 +221,9 @@ bool Config::performHttpConfigUpdate(const String& firmwareVersion, Console* con
   int httpCode = JSONAPIClient::performRequest(
     *ManageWifiClient::getClient(http_config_url.c_str()),
     JSONAPIClient::HTTP_METHOD_GET,
-    http_config_url.c_str(),
-    "",
-    requestHeader,
+    *httpConfigRequest,
     requestBody,
-    configJsonDoc,
-    http_config_username.c_str(),
-    http_config_password.c_str()
+    configJsonDoc
   );
 
   bool result = false;
@@ -224,11 +236,11 @@ bool Config::performHttpConfigUpdate(const String& firmwareVersion, Console* con
         result = true;
         saved = true;
         if (console) {
-          console->log(Console::INFO, F("Successfully updated config via HTTP from %s"), http_config_url.c_str());
+          CONSOLE_LOG(*console, Console::MODULE_HTTP, Console::INFO, "Successfully updated config via HTTP from %s", http_config_url.c_str());
         }
       } else {
         if (console) {
-          console->log(Console::ERROR, F("Failed to save config"));
+          CONSOLE_LOG(*console, Console::MODULE_HTTP, Console::ERROR, "Failed to save config");
         }
       }
       break;
@@ -236,16 +248,16 @@ bool Config::performHttpConfigUpdate(const String& firmwareVersion, Console* con
     case HTTP_CODE_NOT_MODIFIED:
     case HTTP_CODE_NO_CONTENT:
       if (console) {
-        console->log(Console::INFO, F("No Config Update available via HTTP"));
+        CONSOLE_LOG(*console, Console::MODULE_HTTP, Console::INFO, "No Config Update available via HTTP");
       }
       result = true;
       break;
       
     default:
       if (console) {
-        console->log(Console::ERROR, F("HTTP request %s failed with code: %d"), http_config_url.c_str(), httpCode);
+        CONSOLE_LOG(*console, Console::MODULE_HTTP, Console::ERROR, "HTTP request %s failed with code: %d", http_config_url.c_str(), httpCode);
         if (configJsonDoc.containsKey("message")) {
-          console->log(Console::ERROR, F("message: %s"), configJsonDoc["message"].as<String>().c_str());
+          CONSOLE_LOG(*console, Console::MODULE_HTTP, Console::ERROR, "message: %s", configJsonDoc["message"].as<String>().c_str());
         }
       }
   }
@@ -14,6 +14,7 @@ class Config
 {
 public:
     Config();
+    ~Config();
 
     int exists(const char *configKey);
     int get(const char *configKey, int defaultValue);
@@ -42,6 +43,8 @@ protected:
     const char *HTTP_CONFIG_URL = "http://192.168.0.1:8080/config";
     const char *HTTP_CONFIG_USERNAME = "user";
     const char *HTTP_CONFIG_PASSWORD = "myuserpw";
+    // config URL, credentials and version headers, built on the first update check
+    PreparedRequest *httpConfigRequest = nullptr;
 #endif // HTTP_CONFIG
 
     DynamicJsonDocument configJsonDoc;
@@ -1,75 +1,380 @@
 #include "Console.h"
 #include <Arduino.h>
 
+// Little endian field writer for binary log records. Counts the required length
+// even when the output is full so the caller can grow the buffer and retry.
+struct RecordWriter
+{
+    uint8_t *out;
+    size_t capacity;
+    size_t length;
+
+    void put(const void *data, size_t size)
+    {
+        if (length + size <= capacity)
+            memcpy_P(out + length, data, size); // data may be a PROGMEM string
+        length += size;
+    }
+
+    void putUint(uint32_t value, size_t size)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            if (length < capacity)
+                out[length] = (uint8_t)(value >> (8 * i));
+            length++;
+        }
+    }
+};
+
+// Walks the (PROGMEM) format string and stores the raw varargs it consumes
+static size_t encodeArguments(uint8_t *out, size_t capacity, const char *fmt, va_list arg)
+{
+    RecordWriter writer = {out, capacity, 0};
+    const char *p = fmt;
+    char c;
+
+    while ((c = pgm_read_byte(p++)) != '\0')
+    {
+        if (c != '%')
+            continue;
+
+        c = pgm_read_byte(p++);
+        if (c == '%')
+            continue;
+
+        while (c == '-' || c == '+' || c == ' ' || c == '#' || c == '0')
+            c = pgm_read_byte(p++);
+
+        if (c == '*')
+        {
+            writer.putUint(va_arg(arg, int), 4);
+            c = pgm_read_byte(p++);
+        }
+        while (c >= '0' && c <= '9')
+            c = pgm_read_byte(p++);
+
+        if (c == '.')
+        {
+            c = pgm_read_byte(p++);
+            if (c == '*')
+            {
+                writer.putUint(va_arg(arg, int), 4);
+                c = pgm_read_byte(p++);
+            }
+            while (c >= '0' && c <= '9')
+                c = pgm_read_byte(p++);
+        }
+
+        bool wide = false;
+        while (c == 'h' || c == 'l' || c == 'j' || c == 'z' || c == 't' || c == 'L')
+        {
+            if (c == 'j' || (c == 'l' && pgm_read_byte(p) == 'l'))
+                wide = true;
+            c = pgm_read_byte(p++);
+        }
+
+        switch (c)
+        {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+        case 'c':
+            if (wide)
+            {
+                long long value = va_arg(arg, long long);
+                writer.put(&value, sizeof(value));
+            }
+            else
+                writer.putUint(va_arg(arg, unsigned int), 4);
+            break;
+        case 'p':
+            writer.putUint((uint32_t)(uintptr_t)va_arg(arg, void *), 4);
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+        {
+            double value = va_arg(arg, double);
+            writer.put(&value, sizeof(value));
+            break;
+        }
+        case 's':
+        {
+            const char *str = va_arg(arg, const char *);
+            if (str == nullptr)
+                str = "(null)";
+            size_t strLength = strnlen_P(str, 255);
+            writer.putUint(strLength, 1);
+            writer.put(str, strLength);
+            break;
+        }
+        case 'n':
+            va_arg(arg, int *); // never written to
+            break;
+        default:
+            return writer.length; // malformed or end of format
+        }
+    }
+    return writer.length;
+}
+
 // Constructor
 Console::Console()
 {
-    primaryStream = &Serial;
-    SecondaryOutputStream = nullptr;
+    inputStream = &Serial;
+    addSink(Serial, DEBUG, SINK_FLUSH_LINE);
+}
+
+Console::~Console()
+{
+    free(lineBuffer);
 }
 
 // Required Stream functions to implement
 size_t Console::write(uint8_t data)
 {
-    // write to secondary output
-    if (SecondaryOutputStream != nullptr)
-        SecondaryOutputStream->write(data);
+    return write(&data, 1);
+}
+
+size_t Console::write(const uint8_t *buffer, size_t size)
+{
+    if (size == 0)
+        return 0;
+
+    size_t written = 0;
+    for (uint8_t i = 0; i < sinkCount; i++)
+    {
+        // plain output follows the filter of the log line it belongs to
+        if (printLevel < sinks[i].level || printLevel > sinks[i].maxLevel)
+            continue;
+        size_t sinkWritten = (sinks[i].policy & SINK_RECORDS)
+                                 ? writeTextRecords(sinks[i], buffer, size)
+                                 : writeToSink(sinks[i], printLevel, buffer, size);
+        if (sinkWritten > written)
+            written = sinkWritten;
+    }
+    return written;
+}
+
+// Writes to one sink according to its policy. A non-blocking sink takes the
+// whole span or nothing, so lines and records are never split.
+size_t Console::writeToSink(Sink &sink, LogLevel level, const uint8_t *buffer, size_t size)
+{
+    if (sink.policy & SINK_NONBLOCKING)
+    {
+        int space = sink.stream->availableForWrite();
+        if (space > 0)
+            sink.spaceReported = true;
+        // a stream that never reported space likely does not implement
+        // availableForWrite(): write blocking rather than drop everything
+        if (space < (int)size && sink.spaceReported)
+        {
+            sink.droppedBytes += size;
+            return 0;
+        }
+    }
+
+    size_t written = sink.leveled != nullptr ? sink.leveled->writeLeveled(level, buffer, size)
+                                             : sink.stream->write(buffer, size);
+    if (written < size)
+        sink.droppedBytes += size - written;
+    return written;
+}
+
+// Wraps plain text into RECORD_TEXT records so it can share a record sink with log records.
+// Each record is written with one call so a rejected write never leaves a partial record behind.
+size_t Console::writeTextRecords(Sink &sink, const uint8_t *buffer, size_t size)
+{
+    if (!reserveLineBuffer(LINE_BUFFER_INITIAL_SIZE))
+        return 0;
+
+    size_t written = 0;
+    while (written < size)
+    {
+        size_t chunk = size - written;
+        if (chunk > lineBufferSize - RECORD_TEXT_HEADER_SIZE)
+            chunk = lineBufferSize - RECORD_TEXT_HEADER_SIZE;
+
+        uint8_t *record = reinterpret_cast<uint8_t *>(lineBuffer);
+        record[0] = RECORD_TEXT;
+        record[1] = (uint8_t)chunk;
+        record[2] = (uint8_t)(chunk >> 8);
+        memcpy(record + RECORD_TEXT_HEADER_SIZE, buffer + written, chunk);
 
-    // Print the data to the current stream
-    return primaryStream->write(data);
+        if (writeToSink(sink, printLevel, record, RECORD_TEXT_HEADER_SIZE + chunk) == 0)
+            break;
+        written += chunk;
+    }
+    return written;
 }
 
 void Console::flush() {
-    // flush secondary output
-    if (SecondaryOutputStream != nullptr)
-        SecondaryOutputStream->flush();
+    drainDeferred();
+    // pending summaries must not be lost before sleep
+    flushRepeats();
+    for (uint8_t i = 0; i < RATE_LIMIT_SLOTS; i++)
+        flushSuppressed(rateLimitSlots[i]);
 
-    // flush primary
-    return primaryStream->flush();
+    for (uint8_t i = 0; i < sinkCount; i++)
+        sinks[i].stream->flush();
 }
 
 
 int Console::available()
 {
     // Check the availability of input data on the current stream
-    return primaryStream->available();
+    return inputStream->available();
 }
 
 int Console::read()
 {
     // Read a byte of data from the current stream
-    return primaryStream->read();
+    return inputStream->read();
 }
 
 int Console::peek()
 {
     // Peek at the next byte of input data from the current stream
-    return primaryStream->peek();
+    return inputStream->peek();
 }
 
 // Function to begin with Serial
 void Console::begin(unsigned long baudRate)
 {
     Serial.begin(baudRate);
-    primaryStream = &Serial;
+    if (findSink(Serial) == nullptr)
+        addSink(Serial);
 }
 
-// Function to begin with a stream e.g. TelnetStream
-void Console::begin(Stream &primary, Stream &secondOutput)
+bool Console::addSink(Stream &stream, LogLevel level, uint8_t policy, LeveledOutput *leveled)
 {
-    primaryStream = &primary;
-    SecondaryOutputStream = &secondOutput;
+    if (findSink(stream) != nullptr || sinkCount >= MAX_SINKS)
+        return false;
+
+    sinks[sinkCount++] = {&stream, level, CRITICAL, policy, 0, leveled, false};
+    updateSinkLevelMinimum();
+    return true;
 }
 
-// Function to begin with a stream e.g. TelnetStream
-void Console::begin(Stream &primary)
+bool Console::removeSink(Stream &stream)
 {
-    primaryStream = &primary;
+    Sink *sink = findSink(stream);
+    if (sink == nullptr)
+        return false;
+
+    // keep the registration order of the remaining sinks
+    size_t index = sink - sinks;
+    memmove(sink, sink + 1, (sinkCount - index - 1) * sizeof(Sink));
+    sinkCount--;
+    if (inputStream == &stream)
+        inputStream = &Serial;
+    updateSinkLevelMinimum();
+    return true;
+}
+
+bool Console::setSinkLevel(Stream &stream, LogLevel level)
+{
+    Sink *sink = findSink(stream);
+    if (sink == nullptr)
+        return false;
+
+    sink->level = level;
+    updateSinkLevelMinimum();
+    return true;
+}
+
+bool Console::setSinkMaxLevel(Stream &stream, LogLevel maxLevel)
+{
+    Sink *sink = findSink(stream);
+    if (sink == nullptr)
+        return false;
+
+    sink->maxLevel = maxLevel;
+    return true;
+}
+
+bool Console::setSinkPolicy(Stream &stream, uint8_t policy)
+{
+    Sink *sink = findSink(stream);
+    if (sink == nullptr)
+        return false;
+
+    sink->policy = policy;
+    return true;
+}
+
+uint32_t Console::getSinkDroppedBytes(Stream &stream) const
+{
+    const Sink *sink = findSink(stream);
+    return sink != nullptr ? sink->droppedBytes : 0;
+}
+
+void Console::setInputStream(Stream &stream)
+{
+    inputStream = &stream;
+}
+
+Console::Sink *Console::findSink(Stream &stream)
+{
+    for (uint8_t i = 0; i < sinkCount; i++)
+        if (sinks[i].stream == &stream)
+            return &sinks[i];
+    return nullptr;
+}
+
+const Console::Sink *Console::findSink(Stream &stream) const
+{
+    for (uint8_t i = 0; i < sinkCount; i++)
+        if (sinks[i].stream == &stream)
+            return &sinks[i];
+    return nullptr;
+}
+
+void Console::updateSinkLevelMinimum()
+{
+    sinkLevelMinimum = CRITICAL;
+    for (uint8_t i = 0; i < sinkCount; i++)
+        if (sinks[i].level < sinkLevelMinimum)
+            sinkLevelMinimum = sinks[i].level;
 }
 
 void Console::setLogLevel(LogLevel level)
 {
     logLevelThreshold = level;
+    for (int module = 0; module < MODULE_COUNT; module++)
+        moduleLevelThreshold[module] = level;
+}
+
+void Console::setLogLevel(LogModule module, LogLevel level)
+{
+    if (module >= 0 && module < MODULE_COUNT)
+        moduleLevelThreshold[module] = level;
+}
+
+const char *Console::getModuleName(LogModule module)
+{
+    switch (module)
+    {
+    case MODULE_BASEAPP:
+        return "baseapp";
+    case MODULE_CONFIG:
+        return "config";
+    case MODULE_HTTP:
+        return "http";
+    case MODULE_APP:
+        return "app";
+    default:
+        return "unknown";
+    }
 }
 
 const char *Console::getLogLevelString(LogLevel level)
@@ -114,36 +419,387 @@ void Console::log(LogLevel level, const __FlashStringHelper *format, ...)
 {
     if (level >= logLevelThreshold)
     {
-        const char *fmt = reinterpret_cast<const char *>(format);
-
-        time_t localTime = time(nullptr);
-        struct tm *tm = localtime(&localTime);
-
-        // Create a temp string using strftime() function with stored time format
-        char temp[100];
-        strftime(temp, sizeof(temp), timeFormat, tm);
-        print(temp);
-        print(" ");
-
-        // log level
-        print(getLogLevelString(level));
-        print(" ");
+        va_list arg;
+        va_start(arg, format);
+        vlog(level, time(nullptr), reinterpret_cast<const char *>(format), arg);
+        va_end(arg);
+    }
+}
 
+void Console::log(LogModule module, LogLevel level, const __FlashStringHelper *format, ...)
+{
+    if (isEnabled(module, level))
+    {
         va_list arg;
         va_start(arg, format);
-        vsnprintf(temp, sizeof(temp), fmt, arg);
+        vlog(level, time(nullptr), reinterpret_cast<const char *>(format), arg);
         va_end(arg);
-        print(temp);
-        print("\n");
+    }
+}
+
+// Producer side of the deferred queue, safe in Ticker and interrupt context:
+// no allocation, no locks, no I/O
+bool IRAM_ATTR Console::enqueueDeferred(LogLevel level, const __FlashStringHelper *format, const uintptr_t *args)
+{
+    if (level < logLevelThreshold)
+        return true;
+
+    uint8_t head = deferredHead.load(std::memory_order_relaxed);
+    uint8_t next = (head + 1) & (DEFERRED_QUEUE_SIZE - 1);
+    if (next == deferredTail.load(std::memory_order_acquire))
+    {
+        deferredDropped++;
+        return false; // full
+    }
+
+    DeferredRecord &record = deferredQueue[head];
+    record.format = format;
+    record.level = level;
+    record.millis = millis();
+    for (uint8_t i = 0; i < DEFERRED_MAX_ARGS; i++)
+        record.args[i] = args[i];
+
+    deferredHead.store(next, std::memory_order_release);
+    return true;
+}
+
+// Consumer side of the deferred queue, called from loop context only
+size_t Console::drainDeferred(uint32_t budgetMicros)
+{
+    uint32_t start = micros();
+    uint8_t tail = deferredTail.load(std::memory_order_relaxed);
 
-        // For HardwareSerial, call flush to ensure all data is sent for debugging
-        if (primaryStream == &Serial) {
-            primaryStream->flush();
+    while (tail != deferredHead.load(std::memory_order_acquire))
+    {
+        const DeferredRecord &record = deferredQueue[tail];
+        // timestamp of the enqueue, not of the drain
+        time_t when = time(nullptr) - (time_t)((millis() - record.millis) / 1000);
+        logDeferredRecord(record.level, when, reinterpret_cast<const char *>(record.format),
+                          record.args[0], record.args[1], record.args[2], record.args[3]);
+
+        tail = (tail + 1) & (DEFERRED_QUEUE_SIZE - 1);
+        deferredTail.store(tail, std::memory_order_release);
+
+        if (budgetMicros != 0 && (uint32_t)(micros() - start) >= budgetMicros)
+            break;
+    }
+
+    uint32_t dropped = deferredDropped;
+    if (dropped != 0)
+    {
+        deferredDropped = 0;
+        log(WARNING, F("Deferred log queue full, dropped %u records"), dropped);
+    }
+
+    return (uint8_t)(deferredHead.load(std::memory_order_acquire) - tail) & (DEFERRED_QUEUE_SIZE - 1);
+}
+
+// Turns the stored arguments back into varargs for the formatter
+void Console::logDeferredRecord(LogLevel level, time_t when, const char *fmt, ...)
+{
+    va_list arg;
+    va_start(arg, fmt);
+    vlog(level, when, fmt, arg);
+    va_end(arg);
+}
+
+void Console::vlog(LogLevel level, time_t when, const char *fmt, va_list arg)
+{
+    if (level < sinkLevelMinimum || !reserveLineBuffer(LINE_BUFFER_INITIAL_SIZE) ||
+        isDuplicate(level, fmt, arg) || isRateLimited(level, fmt))
+    {
+        // plain output following a filtered or suppressed line belongs to it,
+        // not to the last line written (or summary line flushed by the filters)
+        printLevel = level;
+        return;
+    }
+
+    voutput(level, when, fmt, arg);
+}
+
+// Formats or encodes one log line and writes it to the sinks, no filtering
+void Console::voutput(LogLevel level, time_t when, const char *fmt, va_list arg)
+{
+    // text and records are only produced if a sink wants them
+    bool textWanted = false;
+    bool recordWanted = false;
+    for (uint8_t i = 0; i < sinkCount; i++)
+    {
+        if (level >= sinks[i].level && level <= sinks[i].maxLevel)
+        {
+            if (sinks[i].policy & SINK_RECORDS)
+                recordWanted = true;
+            else
+                textWanted = true;
         }
+    }
+
+    if (textWanted)
+    {
+        va_list textArg;
+        va_copy(textArg, arg);
+        size_t prefixLength = formatPrefix(level, when);
+        size_t length = formatMessage(prefixLength, fmt, textArg);
+        va_end(textArg);
+        writeLine(level, false, lineBuffer, length, prefixLength);
+    }
+
+    if (recordWanted)
+    {
+        size_t length = encodeRecord(0, level, when, fmt, arg);
+        if (length > 0)
+            writeLine(level, true, lineBuffer, length);
+    }
+}
+
+// Summary lines of deduplication and rate limiting bypass both filters
+void Console::logSummary(LogLevel level, const __FlashStringHelper *format, ...)
+{
+    va_list arg;
+    va_start(arg, format);
+    voutput(level, time(nullptr), reinterpret_cast<const char *>(format), arg);
+    va_end(arg);
+}
+
+// True if the line has the same format and arguments as the previous one.
+// The arguments are compared by a hash of their binary encoding (strings by content).
+bool Console::isDuplicate(LogLevel level, const char *fmt, va_list arg)
+{
+    if (!deduplicate)
+        return false;
+
+    va_list hashArg;
+    va_copy(hashArg, arg);
+    size_t length = encodeArguments(reinterpret_cast<uint8_t *>(lineBuffer), lineBufferSize, fmt, hashArg);
+    va_end(hashArg);
+    if (length > lineBufferSize)
+        length = lineBufferSize;
 
-        if (SecondaryOutputStream != nullptr && SecondaryOutputStream == &Serial) {
-            SecondaryOutputStream->flush();
-        }  
+    // FNV-1a over the format address and the encoded arguments
+    uint32_t hash = 2166136261u;
+    uintptr_t address = (uintptr_t)fmt;
+    for (size_t i = 0; i < sizeof(address); i++)
+        hash = (hash ^ (uint8_t)(address >> (8 * i))) * 16777619u;
+    for (size_t i = 0; i < length; i++)
+        hash = (hash ^ (uint8_t)lineBuffer[i]) * 16777619u;
+
+    if (fmt == dedupFormat && hash == dedupHash && level == dedupLevel)
+    {
+        dedupRepeats++;
+        return true;
+    }
+
+    flushRepeats();
+    dedupFormat = fmt;
+    dedupHash = hash;
+    dedupLevel = level;
+    return false;
+}
+
+void Console::flushRepeats()
+{
+    if (dedupRepeats > 0)
+    {
+        uint32_t repeats = dedupRepeats;
+        dedupRepeats = 0;
+        logSummary(dedupLevel, F("Last message repeated %u times"), repeats);
+    }
+}
+
+// True if the call site (identified by its format string) exceeded rateLimitLines in the current window
+bool Console::isRateLimited(LogLevel level, const char *fmt)
+{
+    if (rateLimitLines == 0)
+        return false;
+
+    uint32_t now = millis();
+    RateLimitSlot *slot = nullptr;
+    RateLimitSlot *oldest = &rateLimitSlots[0];
+    for (uint8_t i = 0; i < RATE_LIMIT_SLOTS; i++)
+    {
+        RateLimitSlot &candidate = rateLimitSlots[i];
+        if (candidate.format == fmt)
+        {
+            slot = &candidate;
+            break;
+        }
+        if (oldest->format != nullptr &&
+            (candidate.format == nullptr || now - candidate.windowStart > now - oldest->windowStart))
+            oldest = &candidate;
+    }
+
+    if (slot == nullptr)
+    {
+        // reuse a free slot or the one with the oldest window
+        slot = oldest;
+        flushSuppressed(*slot);
+        slot->format = fmt;
+        slot->windowStart = now;
+        slot->count = 0;
+    }
+    else if (now - slot->windowStart >= rateLimitWindowMillis)
+    {
+        flushSuppressed(*slot);
+        slot->windowStart = now;
+        slot->count = 0;
+    }
+
+    if (slot->count < rateLimitLines)
+    {
+        slot->count++;
+        return false;
+    }
+
+    if (slot->suppressed == 0 || level > slot->level)
+        slot->level = level;
+    slot->suppressed++;
+    return true;
+}
+
+void Console::flushSuppressed(RateLimitSlot &slot)
+{
+    if (slot.suppressed > 0)
+    {
+        uint32_t suppressed = slot.suppressed;
+        slot.suppressed = 0;
+        logSummary(slot.level, F("Rate limit suppressed %u lines of \"%s\""), suppressed, slot.format);
+    }
+}
+
+void Console::setDeduplicate(bool enable)
+{
+    flushRepeats();
+    deduplicate = enable;
+    dedupFormat = nullptr;
+}
+
+void Console::setRateLimit(uint16_t lines, uint32_t windowMillis)
+{
+    for (uint8_t i = 0; i < RATE_LIMIT_SLOTS; i++)
+    {
+        flushSuppressed(rateLimitSlots[i]);
+        rateLimitSlots[i].format = nullptr;
+    }
+    rateLimitLines = lines;
+    rateLimitWindowMillis = windowMillis;
+}
+
+// Encodes a RECORD_LOG at offset in lineBuffer and returns the record length (0 if it does not fit)
+size_t Console::encodeRecord(size_t offset, LogLevel level, time_t when, const char *fmt, va_list arg)
+{
+    va_list retryArg;
+    va_copy(retryArg, arg);
+
+    size_t argOffset = offset + RECORD_LOG_HEADER_SIZE;
+    size_t argLength = encodeArguments(reinterpret_cast<uint8_t *>(lineBuffer) + argOffset,
+                                       lineBufferSize - argOffset, fmt, arg);
+    if (argOffset + argLength > lineBufferSize && reserveLineBuffer(argOffset + argLength))
+        encodeArguments(reinterpret_cast<uint8_t *>(lineBuffer) + argOffset,
+                        lineBufferSize - argOffset, fmt, retryArg);
+    va_end(retryArg);
+
+    if (argOffset + argLength > lineBufferSize || argLength > 0xFFFF)
+        return 0; // arguments too large for LINE_BUFFER_MAX_SIZE
+
+    RecordWriter header = {reinterpret_cast<uint8_t *>(lineBuffer) + offset, RECORD_LOG_HEADER_SIZE, 0};
+    header.putUint(RECORD_LOG, 1);
+    header.putUint(level, 1);
+    header.putUint((uint32_t)when, 4);
+    header.putUint((uint32_t)(uintptr_t)fmt, 4);
+    header.putUint(argLength, 2);
+
+    return RECORD_LOG_HEADER_SIZE + argLength;
+}
+
+bool Console::reserveLineBuffer(size_t size)
+{
+    if (size > LINE_BUFFER_MAX_SIZE)
+        size = LINE_BUFFER_MAX_SIZE;
+    if (size <= lineBufferSize)
+        return true;
+
+    char *grown = static_cast<char *>(realloc(lineBuffer, size));
+    if (grown == nullptr)
+        return lineBuffer != nullptr; // keep using the smaller buffer
+
+    lineBuffer = grown;
+    lineBufferSize = size;
+    return true;
+}
+
+// Writes "<time> <LEVEL> " to the start of lineBuffer and returns its length
+size_t Console::formatPrefix(LogLevel level, time_t localTime)
+{
+    if (localTime != timePrefixSecond)
+    {
+        struct tm *tm = localtime(&localTime);
+        timePrefixLength = strftime(timePrefix, sizeof(timePrefix), timeFormat, tm);
+        timePrefixSecond = localTime;
+    }
+
+    size_t length = timePrefixLength;
+    memcpy(lineBuffer, timePrefix, length);
+
+    if (timeMillis)
+    {
+        lineBuffer[length++] = '[';
+        ultoa(millis(), lineBuffer + length, 10);
+        length += strlen(lineBuffer + length);
+        lineBuffer[length++] = ']';
+    }
+    lineBuffer[length++] = ' ';
+
+    const char *levelString = getLogLevelString(level);
+    size_t levelLength = strlen(levelString);
+    memcpy(lineBuffer + length, levelString, levelLength);
+    length += levelLength;
+    lineBuffer[length++] = ' ';
+
+    return length;
+}
+
+// Appends the formatted message and a newline at offset and returns the total line length.
+// First pass formats into the current buffer; if the message did not fit, the buffer
+// is grown once (up to LINE_BUFFER_MAX_SIZE) and the message is formatted again.
+size_t Console::formatMessage(size_t offset, const char *fmt, va_list arg)
+{
+    va_list retryArg;
+    va_copy(retryArg, arg);
+
+    // reserve 1 byte for the newline, vsnprintf reserves the null terminator
+    int needed = vsnprintf(lineBuffer + offset, lineBufferSize - offset - 1, fmt, arg);
+    if (needed < 0)
+        needed = 0;
+
+    size_t required = offset + needed + 2; // newline and null terminator
+    if (required > lineBufferSize && reserveLineBuffer(required))
+        vsnprintf(lineBuffer + offset, lineBufferSize - offset - 1, fmt, retryArg);
+    va_end(retryArg);
+
+    size_t length = offset + needed;
+    if (length > lineBufferSize - 2)
+        length = lineBufferSize - 2; // truncated to LINE_BUFFER_MAX_SIZE
+
+    lineBuffer[length++] = '\n';
+    lineBuffer[length] = '\0';
+    return length;
+}
+
+// Sends a complete line (or record) to every sink of that kind accepting the level, with a single write each.
+// Sinks with SINK_NO_PREFIX get the text line from prefixLength on.
+void Console::writeLine(LogLevel level, bool record, const char *line, size_t length, size_t prefixLength)
+{
+    printLevel = level;
+    for (uint8_t i = 0; i < sinkCount; i++)
+    {
+        Sink &sink = sinks[i];
+        if (level < sink.level || level > sink.maxLevel || ((sink.policy & SINK_RECORDS) != 0) != record)
+            continue;
+
+        size_t skip = (sink.policy & SINK_NO_PREFIX) ? prefixLength : 0;
+        writeToSink(sink, level, reinterpret_cast<const uint8_t *>(line) + skip, length - skip);
+        if (sink.policy & SINK_FLUSH_LINE)
+            sink.stream->flush();
     }
 }
 
@@ -153,5 +809,11 @@ void Console::setTimeFormat(const char *format) {
         strncpy(timeFormat, format, sizeof(timeFormat) - 1);
         // Ensure null termination
         timeFormat[sizeof(timeFormat) - 1] = '\0';
+        // Force the cached timestamp to be rebuilt with the new format
+        timePrefixSecond = -1;
     }
+}
+
+void Console::setTimeMillis(bool enable) {
+    timeMillis = enable;
 }
\ No newline at end of file
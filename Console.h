@@ -2,6 +2,26 @@
 #define CONSOLE_H
 
 #include <Arduino.h>
+#include <atomic>
+#include <type_traits>
+#include "features.h"
+#include "LeveledOutput.h"
+
+// Build-time minimum log level: CONSOLE_LOG call sites below it are removed by the
+// compiler together with their arguments and format strings
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 10
+#endif
+
+// Preferred logging front end. Arguments are only evaluated if the level is compiled in
+// and enabled for the module, e.g.
+// CONSOLE_LOG(console, Console::MODULE_APP, Console::DEBUG, "Free heap: %d", ESP.getFreeHeap());
+#define CONSOLE_LOG(console, module, level, format, ...)                      \
+    do                                                                        \
+    {                                                                         \
+        if (Console::isCompiledIn(level) && (console).isEnabled(module, level)) \
+            (console).log(module, level, F(format), ##__VA_ARGS__);           \
+    } while (0)
 
 class Console : public Stream
 {
@@ -15,46 +35,236 @@ public:
         CRITICAL = 50
     };
 
+    // Modules with their own runtime log level
+    enum LogModule
+    {
+        MODULE_BASEAPP,
+        MODULE_CONFIG,
+        MODULE_HTTP,
+        MODULE_APP,
+        MODULE_COUNT
+    };
+
+    // Per sink buffering policy, can be combined
+    enum SinkPolicy : uint8_t
+    {
+        SINK_BLOCKING = 0x00,    // write everything, waits if the stream is slow
+        SINK_NONBLOCKING = 0x01, // write only what availableForWrite() accepts, count the rest as dropped;
+                                 // blocking until the stream reports space once (Print's default is 0)
+        SINK_FLUSH_LINE = 0x02,  // flush after every log line e.g. Serial while debugging crashes
+        SINK_RECORDS = 0x04,     // receives binary log records instead of text (see RECORD_LOG)
+        SINK_NO_PREFIX = 0x08    // log lines without the time and level prefix, e.g. syslog with its own header
+    };
+
+    static const uint8_t MAX_SINKS = 4;
+
     // Constructor
     Console();
+    ~Console();
 
     // Required Stream functions to implement
     virtual size_t write(uint8_t data) override;
+    // Bulk write: forwards the whole span with one call to each sink whose level
+    // range includes the level of the last log line (see printLevel).
+    // Returns the largest number of bytes accepted by any sink, which may be
+    // less than size (short write). Bytes a sink did not accept are counted
+    // in its dropped bytes.
+    virtual size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
     virtual void flush() override;
+    // Input is read from the input stream (Serial unless set with setInputStream)
     virtual int available() override;
     virtual int read() override;
     virtual int peek() override;
 
-    // Additional functions from Stream that can be implemented if needed
-    // ...
-
     // Function to begin with Serial
     void begin(unsigned long baudRate);
 
-    // Function to begin with a stream e.g. TelnetStream
-    void begin(Stream &primary, Stream &secondOutput);
-
-    // Function to begin with a stream e.g. TelnetStream
-    void begin(Stream &primary);
+    // Sink registry: every sink gets the log lines at or above its own level
+    // and at or below its maximum level (CRITICAL unless set with setSinkMaxLevel),
+    // e.g. to send DEBUG/INFO to one sink and WARNING and above to another.
+    // Serial is registered by the constructor.
+    // A sink that also implements LeveledOutput gets every write tagged with its log level
+    // (plain print output takes the level of the last log line).
+    bool addSink(Stream &stream, LogLevel level = DEBUG, uint8_t policy = SINK_BLOCKING, LeveledOutput *leveled = nullptr);
+    bool removeSink(Stream &stream);
+    bool setSinkLevel(Stream &stream, LogLevel level);
+    bool setSinkMaxLevel(Stream &stream, LogLevel maxLevel);
+    bool setSinkPolicy(Stream &stream, uint8_t policy);
+    uint32_t getSinkDroppedBytes(Stream &stream) const;
+    void setInputStream(Stream &stream);
 
+    // Sets the default level and the level of all modules
     void setLogLevel(LogLevel level);
+    void setLogLevel(LogModule module, LogLevel level);
+
+    static constexpr bool isCompiledIn(LogLevel level) { return level >= LOG_MIN_LEVEL; }
+    bool isEnabled(LogModule module, LogLevel level) const
+    {
+        return level >= moduleLevelThreshold[module] && level >= sinkLevelMinimum;
+    }
+
+    static const char *getModuleName(LogModule module);
 
     static const char *getLogLevelString(LogLevel level);
 
     LogLevel intToLogLevel(int intValue);
 
     void log(LogLevel level, const __FlashStringHelper *format, ...);
+    void log(LogModule module, LogLevel level, const __FlashStringHelper *format, ...);
     
+    // Deferred logging for Ticker, interrupt and SDK callback contexts: only the level, the
+    // format and up to DEFERRED_MAX_ARGS integer or pointer arguments are queued, the line is
+    // formatted and written when drainDeferred() runs in loop context (BaseApp::loop, flush).
+    // The queue is single producer: do not log deferred from contexts that preempt each other.
+    // %s arguments must stay valid until drained (e.g. literals), floating point is not supported.
+    template <typename... Args>
+    inline __attribute__((always_inline)) bool logDeferred(LogLevel level, const __FlashStringHelper *format, Args... args)
+    {
+        static_assert(sizeof...(Args) <= DEFERRED_MAX_ARGS, "logDeferred supports up to DEFERRED_MAX_ARGS arguments");
+        uintptr_t values[DEFERRED_MAX_ARGS] = {toDeferredArg(args)...};
+        return enqueueDeferred(level, format, values);
+    }
+
+    // Writes queued records to the sinks, stops after budgetMicros (0 = until empty).
+    // Returns the number of records still queued.
+    size_t drainDeferred(uint32_t budgetMicros = 0);
+
+    // Collapse identical consecutive lines (same format and arguments) into
+    // "Last message repeated N times". Enabled by default.
+    void setDeduplicate(bool enable);
+
+    // Allow at most lines per call site (format string) within windowMillis, the
+    // number of suppressed lines is logged when the window ends. 0 lines disables.
+    void setRateLimit(uint16_t lines, uint32_t windowMillis);
+
+    static const uint8_t RATE_LIMIT_SLOTS = 8; // call sites tracked at the same time
+
+    static const uint8_t DEFERRED_QUEUE_SIZE = 16; // power of two
+    static const uint8_t DEFERRED_MAX_ARGS = 4;
+
     // Set the time format string (strftime format)
     // Maximum length is 31 characters (plus null terminator)
     void setTimeFormat(const char *format);
 
+    // Append the monotonic uptime in milliseconds to the timestamp e.g. "12:00:01[73512]"
+    void setTimeMillis(bool enable);
+
+    // Binary log records: sinks with SINK_RECORDS receive compact records with the address
+    // of the F() format string and the raw arguments instead of formatted text. The records
+    // are expanded by ESP8266_server_app.py using the strings of the firmware ELF. Plain
+    // print/println output is wrapped into RECORD_TEXT records for these sinks.
+    // Record layout (little endian)
+    // RECORD_LOG:  type(1) level(1) time(4) format address(4) argument length(2) arguments
+    // RECORD_TEXT: type(1) length(2) text
+    // Arguments follow the format string: integers as 4 bytes (8 for ll/j), floating point
+    // as 8 bytes, strings as length(1) + characters. '*' width/precision are 4 byte integers.
+    static const uint8_t RECORD_LOG = 0xB1;
+    static const uint8_t RECORD_TEXT = 0xB2;
+    static const size_t RECORD_LOG_HEADER_SIZE = 12;
+    static const size_t RECORD_TEXT_HEADER_SIZE = 3;
+
+    // Initial and maximum size of the reusable log line buffer. Longer lines are truncated.
+    static const size_t LINE_BUFFER_INITIAL_SIZE = 128;
+    static const size_t LINE_BUFFER_MAX_SIZE = 1024;
+
 protected:
-    Stream *primaryStream;
-    Stream *SecondaryOutputStream;     // backup for output e.g. keep sending to Serial
+    struct Sink
+    {
+        Stream *stream;
+        LogLevel level;
+        LogLevel maxLevel;
+        uint8_t policy;
+        uint32_t droppedBytes;
+        LeveledOutput *leveled;
+        bool spaceReported; // availableForWrite() was seen above 0, see SINK_NONBLOCKING
+    };
+
+    Sink sinks[MAX_SINKS];
+    uint8_t sinkCount = 0;
+    LogLevel sinkLevelMinimum = DEBUG; // lowest level any sink accepts
+    LogLevel printLevel = INFO;        // level of the last log line, used for plain print output
+    Stream *inputStream;
+
     LogLevel logLevelThreshold = INFO; // Default log level is DEBUG
+    LogLevel moduleLevelThreshold[MODULE_COUNT] = {INFO, INFO, INFO, INFO};
     char timeFormat[32] = "%Y-%m-%d %H:%M:%S";  // Default time format
-    
+    bool timeMillis = false;
+
+    // Formatted timestamp cached for the second it was built for.
+    // Rebuilt when the second changes or the time format is set.
+    char timePrefix[48];
+    size_t timePrefixLength = 0;
+    time_t timePrefixSecond = -1;
+
+    // Reusable buffer holding one formatted log line (prefix + message + newline).
+    // It only grows, so after warm-up log() does not allocate.
+    char *lineBuffer = nullptr;
+    size_t lineBufferSize = 0;
+
+    struct DeferredRecord
+    {
+        const __FlashStringHelper *format;
+        uintptr_t args[DEFERRED_MAX_ARGS]; // pointer sized: %s arguments are kept whole
+        uint32_t millis;
+        LogLevel level;
+    };
+
+    // Single producer single consumer ring: head is only written by the producer,
+    // tail only by the consumer
+    DeferredRecord deferredQueue[DEFERRED_QUEUE_SIZE];
+    std::atomic<uint8_t> deferredHead{0};
+    std::atomic<uint8_t> deferredTail{0};
+    volatile uint32_t deferredDropped = 0;
+
+    template <typename T>
+    static inline __attribute__((always_inline)) uintptr_t toDeferredArg(T value)
+    {
+        static_assert(!std::is_floating_point<T>::value, "logDeferred does not support floating point");
+        static_assert(sizeof(T) <= sizeof(uintptr_t), "logDeferred arguments must fit into a pointer (no 64 bit integers)");
+        return (uintptr_t)value;
+    }
+
+    // Deduplication of consecutive lines
+    bool deduplicate = true;
+    const char *dedupFormat = nullptr;
+    uint32_t dedupHash = 0;
+    LogLevel dedupLevel = DEBUG;
+    uint32_t dedupRepeats = 0;
+
+    // Rate limiting per call site
+    struct RateLimitSlot
+    {
+        const char *format;
+        uint32_t windowStart;
+        uint16_t count;
+        uint16_t suppressed;
+        LogLevel level; // highest level of the suppressed lines
+    };
+    RateLimitSlot rateLimitSlots[RATE_LIMIT_SLOTS] = {};
+    uint16_t rateLimitLines = 0;
+    uint32_t rateLimitWindowMillis = 10000;
+
+    bool isDuplicate(LogLevel level, const char *fmt, va_list arg);
+    void flushRepeats();
+    bool isRateLimited(LogLevel level, const char *fmt);
+    void flushSuppressed(RateLimitSlot &slot);
+    void logSummary(LogLevel level, const __FlashStringHelper *format, ...);
+    void voutput(LogLevel level, time_t when, const char *fmt, va_list arg);
+
+    bool enqueueDeferred(LogLevel level, const __FlashStringHelper *format, const uintptr_t *args);
+    void logDeferredRecord(LogLevel level, time_t when, const char *fmt, ...);
+    void vlog(LogLevel level, time_t when, const char *fmt, va_list arg);
+    bool reserveLineBuffer(size_t size);
+    size_t formatPrefix(LogLevel level, time_t localTime);
+    size_t formatMessage(size_t offset, const char *fmt, va_list arg);
+    Sink *findSink(Stream &stream);
+    const Sink *findSink(Stream &stream) const;
+    void updateSinkLevelMinimum();
+    void writeLine(LogLevel level, bool record, const char *line, size_t length, size_t prefixLength = 0);
+    size_t writeToSink(Sink &sink, LogLevel level, const uint8_t *buffer, size_t size);
+    size_t encodeRecord(size_t offset, LogLevel level, time_t when, const char *fmt, va_list arg);
+    size_t writeTextRecords(Sink &sink, const uint8_t *buffer, size_t size);
 };
 
 #endif // CONSOLE_H
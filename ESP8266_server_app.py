@@ -1,8 +1,15 @@
 from flask import Flask, request, Response, jsonify, send_file
 from flask_basicauth import BasicAuth
-from datetime import datetime
+from datetime import datetime, timezone
 import os.path
 import sys
+import re
+import struct
+import base64
+import json
+import codecs
+import socketserver
+import threading
 from urllib.parse import unquote
 
 app = Flask(__name__)
@@ -11,6 +18,9 @@ app = Flask(__name__)
 PORT = 8080
 FIRMWARE_PATH = "./build/" 
 LOG_PATH = "./build/" 
+ELF_PATH = None  # firmware ELF for binary log records, default FIRMWARE_PATH/ESP8266_zoomrec.ino.elf
+LOG_TCP_PORT = 8082  # persistent TCP log connections (TcpLogStream), 0 disables
+SYSLOG_UDP_PORT = 5514  # RFC 5424 syslog datagrams (SyslogStream), 0 disables
 
 # override from command line
 if len(sys.argv)>= 1:
@@ -22,6 +32,15 @@ if len(sys.argv) >= 2:
 if len(sys.argv) >= 3:
     LOG_PATH = sys.argv[3]
 
+if len(sys.argv) >= 5:
+    ELF_PATH = sys.argv[4]
+
+if len(sys.argv) >= 6:
+    LOG_TCP_PORT = int(sys.argv[5])
+
+if len(sys.argv) >= 7:
+    SYSLOG_UDP_PORT = int(sys.argv[6])
+
 # Configure basic authentication
 app.config['BASIC_AUTH_USERNAME'] = "user"
 app.config['BASIC_AUTH_PASSWORD'] = "myuserpw"
@@ -67,25 +86,205 @@ def get_firmware():
     else:
         return '', 304  # Not Modified
     
-# curl -X POST -H "Content-Type: application/json" -u admin:myadminpw -d @log_entry.json http://localhost:8080/log
-@app.route('/log', methods=['POST'])
-@basic_auth.required
-def log_handler():
-    data = request.json
-    log_id = data.get('id')
-    log_content = data.get('content')
-    if log_content:
-        log_content = unquote(log_content)
+# Binary log records (see Console.h). The format string of a RECORD_LOG is referenced by its
+# flash address and read from the sections of the firmware ELF.
+RECORD_LOG = 0xB1
+RECORD_TEXT = 0xB2
+RECORD_LOG_HEADER = struct.Struct('<BBIIH')
+RECORD_TEXT_HEADER = struct.Struct('<BH')
+LOG_LEVELS = {10: 'DEBUG', 20: 'INFO', 30: 'WARNING', 40: 'ERROR', 50: 'CRITICAL'}
+FORMAT_SPEC = re.compile(r'%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d*))?(hh|h|ll|l|j|z|t|L)?([diouxXcpfFeEgGaAsn%])')
 
-    if log_id is None or log_content is None:
-        return jsonify({'error': 'id and content are required'}), 400
+elf_cache = {'path': None, 'mtime': None, 'sections': []}
+binary_pending = {}  # log_id -> bytes of an incomplete record from the previous chunk
+delivery_state = {}  # log_id -> [boot id, highest contiguous sequence number stored]
+log_file_lock = threading.Lock()  # HTTP requests and TCP connections append concurrently
+
+def get_elf_path():
+    return ELF_PATH or os.path.join(FIRMWARE_PATH, 'ESP8266_zoomrec.ino.elf')
+
+def load_elf_sections():
+    # minimal ELF32 little endian section reader: [(address, data)] of all loadable sections
+    path = get_elf_path()
+    mtime = os.path.getmtime(path)
+    if elf_cache['path'] == path and elf_cache['mtime'] == mtime:
+        return elf_cache['sections']
+    with open(path, 'rb') as elf_file:
+        elf = elf_file.read()
+    if elf[:4] != b'\x7fELF' or elf[4] != 1:
+        raise ValueError(f'{path} is not an ELF32 file')
+    shoff, = struct.unpack_from('<I', elf, 0x20)
+    shentsize, shnum = struct.unpack_from('<HH', elf, 0x2E)
+    sections = []
+    for i in range(shnum):
+        _, sh_type, _, sh_addr, sh_offset, sh_size = struct.unpack_from('<IIIIII', elf, shoff + i * shentsize)
+        if sh_addr and sh_type != 8:  # skip SHT_NOBITS (.bss)
+            sections.append((sh_addr, elf[sh_offset:sh_offset + sh_size]))
+    elf_cache.update(path=path, mtime=mtime, sections=sections)
+    return sections
+
+def lookup_format(address):
+    for sh_addr, data in load_elf_sections():
+        if sh_addr <= address < sh_addr + len(data):
+            start = address - sh_addr
+            end = data.find(b'\0', start)
+            return data[start:end if end >= 0 else len(data)].decode('utf-8', 'replace')
+    return None
+
+def format_record(fmt, args):
+    # expand a C printf format with the raw arguments of a RECORD_LOG
+    pos = 0
+
+    def take(fmt_struct):
+        nonlocal pos
+        value, = struct.unpack_from(fmt_struct, args, pos)
+        pos += struct.calcsize(fmt_struct)
+        return value
 
+    def expand(match):
+        nonlocal pos
+        flags, width, precision, length, conv = match.groups()
+        if conv == '%':
+            return '%'
+        if width == '*':
+            width = str(take('<i'))
+        if precision == '*':
+            precision = str(take('<i'))
+        spec = '%' + flags + (width or '') + ('.' + precision if precision is not None else '')
+        wide = length in ('ll', 'j')
+        if conv in 'di':
+            return (spec + 'd') % take('<q' if wide else '<i')
+        if conv in 'uoxX':
+            return (spec + ('d' if conv == 'u' else conv)) % take('<Q' if wide else '<I')
+        if conv == 'c':
+            return (spec + 'c') % chr(take('<Q' if wide else '<I') & 0xFF)
+        if conv == 'p':
+            return '0x%x' % take('<I')
+        if conv in 'fFeEgG':
+            return (spec + conv) % take('<d')
+        if conv in 'aA':
+            return float.hex(take('<d'))
+        if conv == 's':
+            str_length = args[pos]
+            pos += 1
+            value = args[pos:pos + str_length].decode('utf-8', 'replace')
+            pos += str_length
+            return (spec + 's') % value
+        return ''  # %n
+
+    return FORMAT_SPEC.sub(expand, fmt)
+
+def decode_binary_log(data):
+    # returns (text, remaining bytes of an incomplete trailing record)
+    lines = []
+    pos = 0
+    while pos < len(data):
+        record_type = data[pos]
+        if record_type == RECORD_LOG:
+            if len(data) - pos < RECORD_LOG_HEADER.size:
+                break
+            _, level, timestamp, fmt_address, arg_length = RECORD_LOG_HEADER.unpack_from(data, pos)
+            end = pos + RECORD_LOG_HEADER.size + arg_length
+            if end > len(data):
+                break
+            args = data[pos + RECORD_LOG_HEADER.size:end]
+            fmt = lookup_format(fmt_address)
+            if fmt is None:
+                message = f'<unknown format 0x{fmt_address:08x}> {args.hex()}'
+            else:
+                try:
+                    message = format_record(fmt, args)
+                except (struct.error, IndexError, TypeError, ValueError):
+                    message = f'<undecodable record "{fmt}"> {args.hex()}'
+            time_str = datetime.fromtimestamp(timestamp).strftime('%Y-%m-%d %H:%M:%S')
+            lines.append(f'{time_str} {LOG_LEVELS.get(level, "UNKNOWN")} {message}\n')
+            pos = end
+        elif record_type == RECORD_TEXT:
+            if len(data) - pos < RECORD_TEXT_HEADER.size:
+                break
+            _, text_length = RECORD_TEXT_HEADER.unpack_from(data, pos)
+            end = pos + RECORD_TEXT_HEADER.size + text_length
+            if end > len(data):
+                break
+            lines.append(data[pos + RECORD_TEXT_HEADER.size:end].decode('utf-8', 'replace'))
+            pos = end
+        else:
+            # lost synchronisation (e.g. dropped chunk): skip to the next record marker
+            pos += 1
+    return ''.join(lines), data[pos:]
+
+def lzss_decompress(data):
+    """Decodes the x-lzss content encoding of the device (see Lzss.h)"""
+    out = bytearray()
+    pos = 0
+    while pos < len(data):
+        flags = data[pos]
+        pos += 1
+        for bit in range(8):
+            if pos >= len(data):
+                break
+            if flags & (1 << bit):
+                out.append(data[pos])
+                pos += 1
+            else:
+                if pos + 2 > len(data):
+                    raise ValueError('truncated back reference')
+                token = data[pos] | (data[pos + 1] << 8)
+                pos += 2
+                distance = (token >> 4) + 1
+                if distance > len(out):
+                    raise ValueError('back reference before start of data')
+                for _ in range((token & 0x0F) + 3):
+                    out.append(out[-distance])
+    return bytes(out)
+
+def request_body():
+    """Request body with the content encoding removed"""
+    data = request.get_data()
+    encoding = request.headers.get('Content-Encoding', 'identity')
+    if encoding == 'x-lzss':
+        return lzss_decompress(data)
+    if encoding != 'identity':
+        raise ValueError(f'unsupported Content-Encoding {encoding}')
+    return data
+
+def decode_binary_chunk(log_id, data):
+    # a record may continue in the next chunk
+    records = binary_pending.pop(log_id, b'') + data
+    log_content, binary_pending[log_id] = decode_binary_log(records)
+    return log_content
+
+def check_batch(log_id, boot, seq):
+    """Returns the sequence to acknowledge if the batch was stored already, else None"""
+    if boot is None or seq is None:
+        return None  # client without sequence numbers
+    state = delivery_state.get(log_id)
+    if state is not None and state[0] == boot and seq <= state[1]:
+        return state[1]
+    return None
+
+def store_batch(log_id, boot, seq):
+    """Records a stored batch and returns the sequence to acknowledge"""
+    if boot is None or seq is None:
+        return None
+    state = delivery_state.get(log_id)
+    if state is None or state[0] != boot:
+        # new boot of the device (or restart of this server): the sequence starts over
+        delivery_state[log_id] = [boot, seq]
+    else:
+        if seq != state[1] + 1:
+            # the device moves on only after an ack, so missing batches cannot be resent
+            print(f'{log_id}: batches {state[1] + 1}..{seq - 1} of boot {boot} missing')
+        state[1] = seq
+    return delivery_state[log_id][1]
+
+def write_log_file(log_id, log_content):
     log_filename = f'{LOG_PATH}{log_id}.log'
 
-    try:
-        # make filename safe for windows
-        log_filename = log_filename.replace(':', '')
-        
+    # make filename safe for windows
+    log_filename = log_filename.replace(':', '')
+
+    with log_file_lock:
         # Check if the log file exists
         if os.path.exists(log_filename):
             mode = 'a'
@@ -96,13 +295,182 @@ def log_handler():
         with open(log_filename, mode) as log_file:
             log_file.write(log_content)
 
+def append_log(log_id, log_content, boot=None, seq=None):
+    try:
+        write_log_file(log_id, log_content)
     except Exception as e:
         print( e)
         return jsonify({'error': str(e)}), 500
 
-    return jsonify({'message': 'Log appended successfully'}), 200
+    ack = store_batch(log_id, boot, seq)
+    if ack is None:
+        return jsonify({'message': 'Log appended successfully'}), 200
+    return jsonify({'message': 'Log appended successfully', 'ack': ack}), 200
+
+def duplicate_response(ack):
+    # stored before, the acknowledgement got lost: confirm again without storing twice
+    return jsonify({'message': 'Duplicate batch ignored', 'ack': ack}), 200
+
+# curl -X POST -H "Content-Type: application/json" -u admin:myadminpw -d @log_entry.json http://localhost:8080/log
+@app.route('/log', methods=['POST'])
+@basic_auth.required
+def log_handler():
+    try:
+        data = json.loads(request_body())
+    except ValueError as e:
+        return jsonify({'error': f'invalid request body: {e}'}), 400
+    log_id = data.get('id')
+    log_content = data.get('content')
+    if log_id is None or log_content is None:
+        return jsonify({'error': 'id and content are required'}), 400
+
+    boot = data.get('boot')
+    seq = data.get('seq')
+    ack = check_batch(log_id, boot, seq)
+    if ack is not None:
+        return duplicate_response(ack)
+
+    if data.get('format') == 'binary':
+        try:
+            log_content = decode_binary_chunk(log_id, base64.b64decode(log_content))
+        except (OSError, ValueError) as e:
+            print(e)
+            return jsonify({'error': f'cannot decode binary log: {e}'}), 500
+    else:
+        log_content = unquote(log_content)
+
+    return append_log(log_id, log_content, boot, seq)
+
+# Log content as request body without encoding, the log id in a header:
+# text/plain for text, application/octet-stream for binary log records
+# Both log routes accept "Content-Encoding: x-lzss" compressed bodies
+# curl -X POST -H "Content-Type: text/plain" -H "X-Log-Id: mylog" -u admin:myadminpw --data-binary "test" http://localhost:8080/log/raw
+@app.route('/log/raw', methods=['POST'])
+@basic_auth.required
+def log_raw_handler():
+    log_id = request.headers.get('X-Log-Id')
+    if not log_id:
+        return jsonify({'error': 'X-Log-Id header is required'}), 400
+
+    boot = request.headers.get('X-Log-Boot')
+    seq = request.headers.get('X-Log-Seq')
+    try:
+        seq = int(seq) if seq is not None else None
+    except ValueError:
+        return jsonify({'error': 'X-Log-Seq must be a number'}), 400
+    ack = check_batch(log_id, boot, seq)
+    if ack is not None:
+        return duplicate_response(ack)
+
+    try:
+        data = request_body()
+    except ValueError as e:
+        return jsonify({'error': f'invalid request body: {e}'}), 400
+    if request.mimetype == 'application/octet-stream':
+        try:
+            log_content = decode_binary_chunk(log_id, data)
+        except (OSError, ValueError) as e:
+            print(e)
+            return jsonify({'error': f'cannot decode binary log: {e}'}), 500
+    else:
+        log_content = data.decode('utf-8', 'replace')
+
+    return append_log(log_id, log_content, boot, seq)
     
+class TcpLogHandler(socketserver.StreamRequestHandler):
+    """One persistent log connection of a device, see TcpLogStream.h:
+    a hello line "LOG1 <text|binary> <base64 user:password> <log id>" followed by log data"""
+
+    def handle(self):
+        hello = self.rfile.readline(512).decode('utf-8', 'replace').rstrip('\r\n').split(' ', 3)
+        if len(hello) != 4 or hello[0] != 'LOG1' or hello[1] not in ('text', 'binary'):
+            print(f'{self.client_address[0]}: invalid log connection hello {hello}')
+            return
+        expected = base64.b64encode(f"{app.config['BASIC_AUTH_USERNAME']}:{app.config['BASIC_AUTH_PASSWORD']}".encode()).decode()
+        if hello[2] != expected:
+            print(f'{self.client_address[0]}: log connection not authorized')
+            return
+        binary = hello[1] == 'binary'
+        log_id = hello[3]
+        print(f'{self.client_address[0]}: {hello[1]} log connection for {log_id}')
+
+        # records and UTF-8 sequences may be split across reads
+        pending = b''
+        text_decoder = codecs.getincrementaldecoder('utf-8')('replace')
+        while True:
+            data = self.rfile.read1(4096)
+            if not data:
+                break
+            try:
+                if binary:
+                    log_content, pending = decode_binary_log(pending + data)
+                else:
+                    log_content = text_decoder.decode(data)
+                if log_content:
+                    write_log_file(log_id, log_content)
+            except (OSError, ValueError) as e:
+                print(e)
+                break
+        print(f'{self.client_address[0]}: log connection for {log_id} closed')
+
+class TcpLogServer(socketserver.ThreadingTCPServer):
+    daemon_threads = True  # a device connection must not keep the app from exiting
+    allow_reuse_address = True
+
+def start_tcp_log_server(port):
+    server = TcpLogServer(('0.0.0.0', port), TcpLogHandler)
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    return server
+
+# <PRI>1 TIMESTAMP HOSTNAME APP-NAME PROCID MSGID STRUCTURED-DATA [MSG]
+SYSLOG_MESSAGE = re.compile(r'<(\d{1,3})>1 (\S+) (\S+) (\S+) (\S+) (\S+) (-|\[.*?\])(?: (.*))?$')
+# syslog severity of the Console levels, see SyslogStream::severity()
+SYSLOG_SEVERITIES = {2: 'CRITICAL', 3: 'ERROR', 4: 'WARNING', 6: 'INFO', 7: 'DEBUG'}
+
+def format_syslog_prefix(pri, timestamp):
+    # the device sends MSG without the console prefix: rebuild it from the header
+    try:
+        when = datetime.strptime(timestamp, '%Y-%m-%dT%H:%M:%SZ').replace(tzinfo=timezone.utc).astimezone()
+    except ValueError:
+        when = datetime.now()  # '-' before the device had NTP time
+    return f'{when.strftime("%Y-%m-%d %H:%M:%S")} {SYSLOG_SEVERITIES.get(int(pri) & 7, "UNKNOWN")} '
+
+class SyslogHandler(socketserver.BaseRequestHandler):
+    """One syslog datagram, batched messages are separated by newlines (not RFC 5426,
+    which has one message per datagram). Messages are appended to the log of their
+    APP-NAME (the log id of the device) with time and level as in the other logs."""
+
+    def handle(self):
+        data = self.request[0].decode('utf-8', 'replace')
+        logs = {}
+        for message in data.split('\n'):
+            match = SYSLOG_MESSAGE.match(message.rstrip('\r'))
+            if match is None:
+                print(f'{self.client_address[0]}: invalid syslog message {message[:80]!r}')
+                continue
+            log_id = match.group(4) if match.group(4) != '-' else match.group(3)
+            logs.setdefault(log_id, []).append(format_syslog_prefix(match.group(1), match.group(2)) + (match.group(8) or '') + '\n')
+        for log_id, lines in logs.items():
+            try:
+                write_log_file(log_id, ''.join(lines))
+            except OSError as e:
+                print(e)
+
+def start_syslog_server(port):
+    # syslog over UDP has no authentication: only listen in trusted networks
+    server = socketserver.ThreadingUDPServer(('0.0.0.0', port), SyslogHandler)
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    return server
+
 if __name__ == '__main__':
+    # HTTP/1.1 keeps the connection of a device open between requests (see JSONAPIClient)
+    from werkzeug.serving import WSGIRequestHandler
+    WSGIRequestHandler.protocol_version = 'HTTP/1.1'
+    # with debug=True the app runs in a reloader child process: only that one serves
+    if LOG_TCP_PORT and os.environ.get('WERKZEUG_RUN_MAIN') == 'true':
+        start_tcp_log_server(LOG_TCP_PORT)
+    if SYSLOG_UDP_PORT and os.environ.get('WERKZEUG_RUN_MAIN') == 'true':
+        start_syslog_server(SYSLOG_UDP_PORT)
     app.run(debug=True,host='0.0.0.0',port=PORT)
 
 
@@ -15,6 +15,14 @@ public:
     deepSleepState.registerVar(&changedPowerState);
   }
 
+  ~ZoomrecApp()
+  {
+    if (pEventApi != nullptr)
+    {
+      delete pEventApi;
+    }
+  }
+
 private:
   const int INPUTPINRESETSWITCH = D1;
   const int OUTPUTPINPOWERBUTTON = D2;
@@ -27,6 +35,9 @@ private:
 
   bool checked = false;
 
+  // event API base URL and credentials, built on the first check, only the path changes per call
+  PreparedRequest *pEventApi = nullptr;
+
   void AppFirmwareVersion()
   {
     FIRMWARE_VERSION = String(__FILE__) + "-" + String(__DATE__) + "-" + String(__TIME__);
@@ -39,13 +50,13 @@ private:
   void AppNTPSet()
   {
     time_t now = time(nullptr);
-    console.log(Console::INFO, F("NTP time received: %s"), ctime(&now));
+    CONSOLE_LOG(console, Console::MODULE_APP, Console::INFO, "NTP time received: %s", ctime(&now));
   }
 
   void AppDeepSleepStateInit()
   {
     changedPowerState = false;
-    console.log(Console::DEBUG, F("DeepSleepState cold boot - initializing: changedPowerState=%d"), changedPowerState);
+    CONSOLE_LOG(console, Console::MODULE_APP, Console::DEBUG, "DeepSleepState cold boot - initializing: changedPowerState=%d", changedPowerState);
   }
 
   void AppSetup()
@@ -55,7 +66,7 @@ private:
     pinMode(INPUTPINRESETSWITCH, INPUT);
     pinMode(OUTPUTPINPOWERBUTTON, OUTPUT);
 
-    console.log(Console::DEBUG, F("DeepSleepState: changedPowerState=%d"), changedPowerState);
+    CONSOLE_LOG(console, Console::MODULE_APP, Console::DEBUG, "DeepSleepState: changedPowerState=%d", changedPowerState);
   }
 
   void AppLoop()
@@ -118,12 +129,12 @@ private:
 
   void checkUpdateStatus()
   {
-    console.log(Console::DEBUG, F("PC powerState: %s"), getPowerState() == PC_ON ? "PC_ON" : "PC_OFF");
+    CONSOLE_LOG(console, Console::MODULE_APP, Console::DEBUG, "PC powerState: %s", getPowerState() == PC_ON ? "PC_ON" : "PC_OFF");
 
     // test http client
     if (!config.exists("http_api_base_url") || (!config.exists("timezone")))
     {
-      console.log(Console::CRITICAL, F("Config 'http_api_base_url' or 'timezone' missing."));
+      CONSOLE_LOG(console, Console::MODULE_APP, Console::CRITICAL, "Config 'http_api_base_url' or 'timezone' missing.");
     }
     else
     {
@@ -132,20 +143,31 @@ private:
       snprintf(path, sizeof(path), "/event/next?client_id=%s&lead_time_sec=%d&trail_time_sec=%d",
         urlEncode(config.get("client_id", "")).c_str(), config.get("leadin_secs", 60), config.get("leadout_secs", 60));
 
-      DynamicJsonDocument responseBody(2048); 
-      StaticJsonDocument<0> emptyRequestHeader;
+      // only the three timestamps are kept, the other event fields are skipped while parsing
+      StaticJsonDocument<JSON_OBJECT_SIZE(3)> nextEventFilter;
+      nextEventFilter["dtstart_instance_lead"] = true;
+      nextEventFilter["dtend_instance_trail"] = true;
+      nextEventFilter["dtnow"] = true;
+      StaticJsonDocument<384> responseBody;
       StaticJsonDocument<0> emptyRequestBody;
 
+      if (pEventApi == nullptr)
+      {
+        pEventApi = new PreparedRequest(
+          config.get("http_api_base_url", ""), "",
+          config.get("http_api_username", ""),
+          config.get("http_api_password", ""));
+      }
+      pEventApi->setPath(path);
+      WiFiClient &apiClient = *ManageWifiClient::getClient(config.get("http_api_base_url", ""));
+
       int httpCode = JSONAPIClient::performRequest(
-        *ManageWifiClient::getClient(config.get("http_api_base_url", "")),
-        JSONAPIClient::HTTP_METHOD_GET, 
-        config.get("http_api_base_url", ""), 
-        path,
-        emptyRequestHeader,
+        apiClient,
+        JSONAPIClient::HTTP_METHOD_GET,
+        *pEventApi,
         emptyRequestBody,
         responseBody,
-        config.get("http_api_username", ""), 
-        config.get("http_api_password", "")
+        &nextEventFilter
       );
 
       const int EVENT_ONGOING_UNKNOWN = -1;
@@ -158,9 +180,11 @@ private:
       {
         case HTTP_CODE_OK:
           if (responseBody.size() > 0) {
-            console.log(Console::DEBUG, F("response for /event/next: "));
-            serializeJsonPretty(responseBody, console);
-            console.println();
+            if (Console::isCompiledIn(Console::DEBUG) && console.isEnabled(Console::MODULE_APP, Console::DEBUG)) {
+              CONSOLE_LOG(console, Console::MODULE_APP, Console::DEBUG, "response for /event/next: ");
+              serializeJsonPretty(responseBody, console);
+              console.println();
+            }
             // extract
             char startStr[50];
             char endStr[50];
@@ -170,7 +194,7 @@ private:
             if (!responseBody.containsKey("dtstart_instance_lead") || 
                 !responseBody.containsKey("dtend_instance_trail") || 
                 !responseBody.containsKey("dtnow")) {
-              console.log(Console::ERROR, F("Missing required fields in response"));
+              CONSOLE_LOG(console, Console::MODULE_APP, Console::ERROR, "Missing required fields in response");
               eventOngoing = EVENT_ONGOING_UNKNOWN;
             }
             else
@@ -182,7 +206,7 @@ private:
               // Additional check for empty strings (though the above check should handle this)
               if ((strlen(startStr) == 0) || (strlen(endStr) == 0) || (strlen(nowStr) == 0))
               {
-                console.log(Console::ERROR, F("response for '/event/next' does not contain dtstart_instance_lead, dtend_instance_trail or dtnow"));
+                CONSOLE_LOG(console, Console::MODULE_APP, Console::ERROR, "response for '/event/next' does not contain dtstart_instance_lead, dtend_instance_trail or dtnow");
                 eventOngoing = EVENT_ONGOING_UNKNOWN;
               }
               else
@@ -202,16 +226,16 @@ private:
           }
           else  
           {
-            console.log(Console::WARNING, F("response with status code %d for '/event/next' is empty"), httpCode);
+            CONSOLE_LOG(console, Console::MODULE_APP, Console::WARNING, "response with status code %d for '/event/next' is empty", httpCode);
             eventOngoing = EVENT_ONGOING_UNKNOWN;
           }
           break;
         case HTTP_CODE_NO_CONTENT:
-          console.log(Console::DEBUG, F("response with status code %d for '/event/next' is empty"), httpCode);
+          CONSOLE_LOG(console, Console::MODULE_APP, Console::DEBUG, "response with status code %d for '/event/next' is empty", httpCode);
           eventOngoing = EVENT_NOT_ONGOING; // no next event but need to check postprocessing
           break;
         default:
-          console.log(Console::WARNING, F("Call to '/event/next' failed with httpCode=%d"), httpCode);
+          CONSOLE_LOG(console, Console::MODULE_APP, Console::WARNING, "Call to '/event/next' failed with httpCode=%d", httpCode);
           eventOngoing = EVENT_ONGOING_UNKNOWN;
           break;
       }
@@ -222,36 +246,36 @@ private:
         snprintf(path, sizeof(path), "/event?Filter.1.Name=status&Filter.1.Operator=%s&Filter.1.Value=%d&Filter.2.Name=assigned&Filter.2.Operator=%s&Filter.2.Value=%s&fields=status",
           urlEncode("="), EVENT_STATUS_POSTPROCESSING, urlEncode("="), urlEncode(config.get("client_id", "")).c_str());
 
-        // Reuse the same TLS settings as the first request
+        // Reuse the same client, TLS settings and kept connection as the first request
+        DynamicJsonDocument postprocessingBody(2048);
+        pEventApi->setPath(path);
         httpCode = JSONAPIClient::performRequest(
-          *ManageWifiClient::getClient(config.get("http_api_base_url", "")),
-          JSONAPIClient::HTTP_METHOD_GET, 
-          config.get("http_api_base_url", ""), 
-          path,
-          emptyRequestHeader, 
-          emptyRequestBody, 
-          responseBody,
-          config.get("http_api_username", ""), 
-          config.get("http_api_password", "")
+          apiClient,
+          JSONAPIClient::HTTP_METHOD_GET,
+          *pEventApi,
+          emptyRequestBody,
+          postprocessingBody
         );
 
         switch (httpCode) {
           case HTTP_CODE_OK:
-            if (responseBody.size() > 0) {
-              console.log(Console::DEBUG, F("response for /event/get: "));
-              serializeJsonPretty(responseBody, console);
-              console.println();
+            if (postprocessingBody.size() > 0) {
+              if (Console::isCompiledIn(Console::DEBUG) && console.isEnabled(Console::MODULE_APP, Console::DEBUG)) {
+                CONSOLE_LOG(console, Console::MODULE_APP, Console::DEBUG, "response for /event/get: ");
+                serializeJsonPretty(postprocessingBody, console);
+                console.println();
+              }
   
               // still in postprocessing
               eventOngoing = EVENT_ONGOING;
             }
             else {
-              console.log(Console::WARNING, F("response with status code %d for '/event/get' is empty"), httpCode);
+              CONSOLE_LOG(console, Console::MODULE_APP, Console::WARNING, "response with status code %d for '/event/get' is empty", httpCode);
               eventOngoing = EVENT_ONGOING_UNKNOWN;
             }
             break;
           case HTTP_CODE_NO_CONTENT:
-            console.log(Console::DEBUG, F("response with status code %d for '/event/get' is empty"), httpCode);
+            CONSOLE_LOG(console, Console::MODULE_APP, Console::DEBUG, "response with status code %d for '/event/get' is empty", httpCode);
             switch (eventOngoing) {
               case EVENT_NOT_ONGOING:
                 eventOngoing = EVENT_NOT_ONGOING; // there was no next event ongoing and also no postprocessing
@@ -265,7 +289,7 @@ private:
             }
             break;
           default:
-            console.log(Console::WARNING, F("Call to '/event/get' failed with httpCode=%d"), httpCode);
+            CONSOLE_LOG(console, Console::MODULE_APP, Console::WARNING, "Call to '/event/get' failed with httpCode=%d", httpCode);
             eventOngoing = EVENT_ONGOING_UNKNOWN;
             break;
         }
@@ -275,35 +299,35 @@ private:
       switch (eventOngoing)
       { 
       case EVENT_ONGOING:
-        console.log(Console::INFO, F("Event ongoing..."));
+        CONSOLE_LOG(console, Console::MODULE_APP, Console::INFO, "Event ongoing...");
         if (getPowerState() == PC_OFF)
         {
-          console.log(Console::INFO, F("Starting PC..."));
+          CONSOLE_LOG(console, Console::MODULE_APP, Console::INFO, "Starting PC...");
           startPC();
           changedPowerState = true; // we changed power state
         }
         break;
       case EVENT_NOT_ONGOING:
-        console.log(Console::INFO, F("No event ongoing..."));
+        CONSOLE_LOG(console, Console::MODULE_APP, Console::INFO, "No event ongoing...");
         if (getPowerState() == PC_ON)
         {
           if (changedPowerState) { // did we change the power state?
-            console.log(Console::INFO, F("Shutting down PC..."));
+            CONSOLE_LOG(console, Console::MODULE_APP, Console::INFO, "Shutting down PC...");
             shutDownPC();
             changedPowerState = false; // reset
           }
         }
         break;
       case EVENT_ONGOING_UNKNOWN:
-        console.log(Console::WARNING, F("Status of event ongoing unknown. No action taken."));
+        CONSOLE_LOG(console, Console::MODULE_APP, Console::WARNING, "Status of event ongoing unknown. No action taken.");
         break;
       default:
-        console.log(Console::ERROR, F("Invalid eventOngoing value: %d"), eventOngoing);
+        CONSOLE_LOG(console, Console::MODULE_APP, Console::ERROR, "Invalid eventOngoing value: %d", eventOngoing);
         break;
       }
     }
 
-    console.log(Console::DEBUG, F("Free heap: %d Max Free Block: %d"), ESP.getFreeHeap(), ESP.getMaxFreeBlockSize());
+    CONSOLE_LOG(console, Console::MODULE_APP, Console::DEBUG, "Free heap: %d Max Free Block: %d", ESP.getFreeHeap(), ESP.getMaxFreeBlockSize());
   }
 };
 
@@ -1,155 +1,421 @@
 #include "HttpStreamBuffered.h"
 #include "JSONAPIClient.h"
-#include <UrlEncode.h>
-
-// Size of the temporary buffer for flushing data
-#define FLUSH_BUFFER_SIZE 256
+#include "Console.h"
+#include "LogBodyStream.h"
+#include "Lzss.h"
+#include <StreamDev.h>
+#include <new>
 
 HttpStreamBuffered::HttpStreamBuffered(WiFiClient& client, const char *logId, const char *url, const char *path, 
                                      const char *http_username, const char *http_password, bool debug)
-  : client(client), overwriting(false), debug(debug) {
+  : client(client), records(CIRCULAR_BUFFER_SIZE), request(url, path, http_username, http_password), debug(debug) {
   if (debug) {
     Serial.printf("[HttpStreamBuffered::HttpStreamBuffered] bufferSize=%d\n", CIRCULAR_BUFFER_SIZE);
   }
   // Store strings directly using String class for better memory management
   this->logId = logId;
-  this->url = url;
-  this->path = path;
-  this->username = http_username;
-  this->password = http_password;
+  snprintf(bootId, sizeof(bootId), "%08x", ESP.random());
 }
 
 HttpStreamBuffered::~HttpStreamBuffered() {
-  // No need to delete anything as we're using String objects now
+  delete replayRecords;
 }
 
 size_t HttpStreamBuffered::write(uint8_t val)
 {
-  if (buffer.available() < 1) {
-    flushBufferedData();
+  return writeLeveled(DEFAULT_LEVEL, &val, 1);
+}
+
+size_t HttpStreamBuffered::write(const uint8_t *buf, size_t size)
+{
+  return writeLeveled(DEFAULT_LEVEL, buf, size);
+}
+
+size_t HttpStreamBuffered::writeLeveled(uint8_t level, const uint8_t *buf, size_t size)
+{
+  if (size == 0) {
+    return 0;
   }
 
-  if (buffer.available() > 0) {
-    long written = buffer.push(val);
-    return written;
+  // never send from here: the caller must not wait on the network
+  if (records.isEmpty()) {
+    pendingSince = millis();
   }
-  else {
-    return 0;
+
+  if (debug) {
+    Serial.printf("[HttpStreamBuffered::write] Writing %d bytes with level %d to buffer, available=%d\n", size, level, records.available());
+  }
+
+  // while the server is unreachable, overflow goes to flash instead of being evicted
+  if (spillQueue != nullptr && retryDelay > 0 && records.available() < LogRecordBuffer::HEADER_SIZE + size) {
+    spillRecords();
+  }
+
+  // pieces of one text line stay one record, binary records are always separate
+  bool merge = !binary && lineOpen;
+  size_t written = records.write(level, buf, size, merge);
+  if (written > 0 && rtcTail != nullptr) {
+    // saved to RTC memory only when a reset is coming, see saveRtcTail()
+    rtcTail->write(level, buf, size, merge);
+    if (suspended) {
+      rtcTail->save();
+    }
   }
+  if (!binary && written > 0) {
+    lineOpen = buf[size - 1] != '\n';
+  }
+  return written;
 }
 
-size_t HttpStreamBuffered::write(const uint8_t *buf, size_t size)
+size_t HttpStreamBuffered::setRtcTail(RtcLogBuffer *tail)
 {
-  if (buffer.available() < size) {
-    flushBufferedData();
+  rtcTail = nullptr;
+  size_t restored = 0;
+  // records of the other content format cannot be decoded by the server
+  if (tail->load() && tail->getTag() == binary) {
+    tail->forEach([this, &restored](uint8_t level, const uint8_t *data, size_t size) {
+      if (records.write(level, data, size) > 0) {
+        restored++;
+      }
+    });
+  } else {
+    tail->clear();
   }
+  lineOpen = false;
 
-  if (debug) {
-    Serial.printf("[HttpStreamBuffered::write] Writing %d bytes to buffer, available=%d\n", size, buffer.available());
+  tail->setTag(binary);
+  tail->save();
+  rtcTail = tail;
+  return restored;
+}
+
+void HttpStreamBuffered::saveRtcTail()
+{
+  if (rtcTail != nullptr) {
+    rtcTail->save();
+  }
+}
+
+void HttpStreamBuffered::setSuspended(bool enable)
+{
+  suspended = enable;
+  if (suspended) {
+    saveRtcTail();
+  }
+}
+
+void HttpStreamBuffered::flush()
+{
+  // one request per batch: the batch in flight, the spilled segments oldest first, then RAM
+  while ((batchPending || !records.isEmpty() || records.hasDropped() || (spillQueue != nullptr && !spillQueue->isEmpty()))
+         && flushBufferedData()) {
   }
+}
 
-  long written = 0;
-  if (buffer.available() >= size) {
-    for (size_t i = 0; i < size; i++) {
-      written += buffer.push(buf[i]);
+void HttpStreamBuffered::setFlushPolicy(size_t watermark, uint32_t maxAgeMillis)
+{
+  flushWatermark = watermark;
+  flushMaxAgeMillis = maxAgeMillis;
+}
+
+void HttpStreamBuffered::poll()
+{
+  if (suspended) {
+    return;
+  }
+
+  // a failed batch is retried with exponential backoff
+  if (batchPending) {
+    if ((unsigned long)(millis() - lastAttempt) >= retryDelay) {
+      flushBufferedData();
     }
+    return;
+  }
+
+  // catch up with the backlog on flash, one segment per call
+  if (spillQueue != nullptr && !spillQueue->isEmpty()) {
+    flushBufferedData();
+    return;
+  }
+
+  if (records.isEmpty()) {
+    return;
+  }
 
-    return written;
+  // Nagle style: collect lines until enough are pending or the oldest is too old
+  if (records.size() >= flushWatermark || (unsigned long)(millis() - pendingSince) >= flushMaxAgeMillis) {
+    flushBufferedData();
   }
-  return 0; // Return 0 if buffer.available() < size
 }
 
-void HttpStreamBuffered::flush()
+void HttpStreamBuffered::setBinary(bool enable)
 {
-  flushBufferedData();
+  // do not mix text and records within one batch
+  flush();
+  if (batchPending) {
+    records.clear();
+    batchPending = false;
+  }
+  binary = enable;
+  lineOpen = false;
+  if (rtcTail != nullptr) {
+    rtcTail->clear();
+    rtcTail->setTag(binary);
+    rtcTail->save();
+  }
 }
 
-void HttpStreamBuffered::flushBufferedData()
+// Sends the next batch, false if it failed or there is nothing to send
+bool HttpStreamBuffered::flushBufferedData()
 {
-  if (buffer.size() == 0) {
-    return; // Nothing to do if buffer is empty
+  if (suspended) {
+    return false; // kept in the RTC tail until the next wake
+  }
+
+  if (!batchPending) {
+    uint32_t dropped[LogRecordBuffer::LEVEL_COUNT];
+    bool reportDropped = records.takeDropped(dropped);
+
+    // records spilled to flash are older than those in RAM
+    batchSource = &records;
+    if (spillQueue != nullptr && !spillQueue->isEmpty()) {
+      if (replayRecords == nullptr) {
+        replayRecords = new (std::nothrow) LogRecordBuffer(SPILL_SEGMENT_SIZE);
+      }
+      if (replayRecords != nullptr && spillQueue->load(*replayRecords)) {
+        batchSource = replayRecords;
+      }
+    }
+
+    if (batchSource->isEmpty() && !reportDropped) {
+      return false; // Nothing to do if buffer is empty
+    }
+
+    // Everything pending becomes the next batch, records lost since the last one are reported first
+    batchSummaryLength = reportDropped ? formatDroppedSummary(batchSummary, sizeof(batchSummary), dropped) : 0;
+    batchSource->mark();
+    batchPending = true;
+  }
+  else if (batchSource->markedSize() == 0 && batchSummaryLength == 0) {
+    // all records of the batch were evicted meanwhile: their loss is counted for the next batch
+    batchPending = false;
+    return true;
   }
 
   if (debug) {
-    Serial.printf("[HttpStreamBuffered] Starting to flush %d bytes to API\n", buffer.size());
-  }
-  
-  // Use a fixed-size buffer to avoid large stack allocations
-  char flushBuffer[FLUSH_BUFFER_SIZE + 1]; // +1 for null terminator
-  size_t bufferIndex = 0;
-  
-  // Process the circular buffer in chunks
-  while (!buffer.isEmpty()) {
-    // Fill the flush buffer up to FLUSH_BUFFER_SIZE or until the circular buffer is empty
-    while (bufferIndex < FLUSH_BUFFER_SIZE && !buffer.isEmpty()) {
-      flushBuffer[bufferIndex++] = buffer.shift();
+    Serial.printf("[HttpStreamBuffered] Sending batch %d with %d bytes to API\n", batchSeq, batchSource->markedSize());
+  }
+
+  lastAttempt = millis();
+  if (!callHttpApi()) {
+    // The batch stays queued and is retried unchanged: the server drops it if it was stored already
+    retryDelay = retryDelay == 0 ? RETRY_DELAY_MIN_MILLIS : retryDelay * 2;
+    if (retryDelay > RETRY_DELAY_MAX_MILLIS) {
+      retryDelay = RETRY_DELAY_MAX_MILLIS;
     }
-    
-    // Null-terminate the buffer
-    flushBuffer[bufferIndex] = '\0';
-    
-    // Send the current chunk
-    if (!callHttpApi(flushBuffer, bufferIndex)) {
-      // On error, we could try to put the data back, but this might cause
-      // an infinite loop if the error persists. For now, we'll just drop the data.
-      if (debug) {
-        Serial.println("[HttpStreamBuffered] Error calling API, dropped data");
-      }
-      break;
+    if (debug) {
+      Serial.printf("[HttpStreamBuffered] Error calling API, retry in %d ms\n", retryDelay);
     }
-    
-    // Reset for next chunk
-    bufferIndex = 0;
+    return false;
   }
-  
-  overwriting = false;
+
+  batchSource->removeMarked();
+  if (batchSource == &records) {
+    // the acknowledged records must not be replayed under a new boot id after a reset,
+    // records written while the request was in flight stay in the tail
+    rebuildRtcTail();
+  }
+  else if (batchSource == replayRecords) {
+    spillQueue->removeOldest();
+    if (spillQueue->isEmpty()) {
+      delete replayRecords;
+      replayRecords = nullptr;
+    }
+    batchSource = &records;
+  }
+  batchPending = false;
+  batchSeq++;
+  retryDelay = 0;
+  if (!records.isEmpty()) {
+    pendingSince = millis();
+  }
+  return true;
 }
 
-bool HttpStreamBuffered::callHttpApi(const char *data, long dataSize) {
-  if (dataSize <= 0 || data == nullptr) {
-    return false;
+// Mirrors the records still in RAM to the RTC tail
+void HttpStreamBuffered::rebuildRtcTail()
+{
+  if (rtcTail == nullptr) {
+    return;
   }
+  rtcTail->clear();
+  records.forEach([this](uint8_t level, const uint8_t *data, size_t size) {
+    rtcTail->write(level, data, size);
+  });
+  rtcTail->save();
+}
 
-  if (debug) {
-    Serial.printf("[HttpStreamBuffered::callHttpApi] Calling API with %d bytes\n", dataSize);
+// Moves the records not in flight to the spill queue on flash
+void HttpStreamBuffered::spillRecords()
+{
+  size_t keep = batchSource == &records ? records.markedSize() : 0;
+  if (records.size() == keep || !spillQueue->spill(records, keep)) {
+    return; // nothing to spill or file system error: evict as usual
+  }
+  records.truncate(keep);
+  lineOpen = false;
+
+  // the spilled records survive a reset on flash already
+  rebuildRtcTail();
+}
+
+// Writes a line with the number of dropped records per level, as text record in binary mode
+size_t HttpStreamBuffered::formatDroppedSummary(char *out, size_t size, const uint32_t *dropped)
+{
+  size_t offset = binary ? Console::RECORD_TEXT_HEADER_SIZE : 0;
+  int length = snprintf(out + offset, size - offset,
+    "[HttpStreamBuffered] dropped records DEBUG=%u INFO=%u WARNING=%u ERROR=%u CRITICAL=%u\n",
+    dropped[0], dropped[1], dropped[2], dropped[3], dropped[4]);
+  if (length < 0) {
+    return 0;
+  }
+  if ((size_t)length > size - offset - 1) {
+    length = size - offset - 1;
+  }
+
+  if (binary) {
+    out[0] = Console::RECORD_TEXT;
+    out[1] = (uint8_t)length;
+    out[2] = (uint8_t)(length >> 8);
+  }
+  return offset + length;
+}
+
+void HttpStreamBuffered::setRaw(bool enable)
+{
+  raw = enable;
+  if (raw) {
+    request.setHeader("X-Log-Id", logId.c_str());
+    request.setHeader("X-Log-Boot", bootId);
+  }
+  else {
+    request.removeHeader("X-Log-Id");
+    request.removeHeader("X-Log-Boot");
+    request.removeHeader("X-Log-Seq");
   }
+}
 
+bool HttpStreamBuffered::callHttpApi() {
   staticJsonRequestBody.clear();
-  staticJsonRequestBody["id"] = logId;
-  
-  // Encode directly without creating a temporary String if possible
-  String encoded;
-  {
-    // Calculate the worst-case encoded size (each character could become %XX)
-    size_t maxEncodedSize = (dataSize * 3) + 1; // 3x for %XX encoding, +1 for null terminator
-    encoded.reserve(maxEncodedSize);
-    encoded = urlEncode(data);
-  }
-  
-  staticJsonRequestBody["content"] = encoded;
-
-  int httpCode = JSONAPIClient::performRequest(
-    client,
-    JSONAPIClient::HTTP_METHOD_POST,
-    url.c_str(),
-    path.c_str(),
-    staticJsonRequestHeader,
-    staticJsonRequestBody,
-    staticJsonResponseBody,
-    username.c_str(),
-    password.c_str()
-  );
+
+  // The envelope up to the content value, which is appended by the body stream
+  String prefix;
+  const char *suffix = "";
+  const char *contentType = "application/json";
+  LogBodyStream::Encoding encoding = LogBodyStream::ENCODING_NONE;
+  if (raw) {
+    char seq[12];
+    snprintf(seq, sizeof(seq), "%u", (unsigned)batchSeq);
+    request.setHeader("X-Log-Seq", seq);
+    contentType = binary ? "application/octet-stream" : "text/plain; charset=utf-8";
+  }
+  else {
+    staticJsonRequestBody["id"] = logId;
+    staticJsonRequestBody["boot"] = bootId;
+    staticJsonRequestBody["seq"] = batchSeq;
+    if (binary) {
+      // records contain null bytes: base64 instead of urlEncode
+      staticJsonRequestBody["format"] = "binary";
+    }
+    serializeJson(staticJsonRequestBody, prefix);
+    prefix.remove(prefix.length() - 1); // closing brace
+    prefix += ",\"content\":\"";
+    suffix = "\"}";
+    encoding = binary ? LogBodyStream::ENCODING_BASE64 : LogBodyStream::ENCODING_URL;
+  }
+
+  LogBodyStream body(*batchSource, batchSource->markedSize(), prefix.c_str(), suffix, batchSummary, batchSummaryLength, encoding);
+
+  // Compressed bodies are built in memory: the size must be known up front.
+  // Only raw bodies are compressed, i.e. the record payload itself; the JSON
+  // envelope would compress its URL/base64 encoding instead.
+  // Without memory or gain the body is streamed uncompressed.
+  uint8_t *plain = nullptr;
+  uint8_t *packed = nullptr;
+  size_t packedSize = 0;
+  bool compressBody = compress && raw && body.size() > 0;
+  // plain and packed copies of the payload plus the Lzss hash chains
+  size_t chainBytes = Lzss::chainBytes(body.size());
+  if (compressBody && (ESP.getMaxFreeBlockSize() < (body.size() > chainBytes ? body.size() : chainBytes)
+                       || ESP.getFreeHeap() < 2 * body.size() + chainBytes + COMPRESS_HEAP_RESERVE)) {
+    compressSkipped++;
+    if (debug) {
+      Serial.printf("[HttpStreamBuffered::callHttpApi] Not compressing %d bytes, free heap %d, max block %d\n",
+                    body.size(), ESP.getFreeHeap(), ESP.getMaxFreeBlockSize());
+    }
+  }
+  else if (compressBody) {
+    plain = new (std::nothrow) uint8_t[body.size()];
+    packed = new (std::nothrow) uint8_t[body.size()];
+    if (plain != nullptr && packed != nullptr) {
+      size_t plainSize = body.read(plain, body.size());
+      packedSize = Lzss::compress(plain, plainSize, packed, plainSize - 1);
+    }
+    delete[] plain;
+  }
+
+  int httpCode;
+  if (packedSize > 0) {
+    if (debug) {
+      Serial.printf("[HttpStreamBuffered::callHttpApi] Calling API with %d bytes compressed from %d\n", packedSize, body.size());
+    }
+    request.setHeader("Content-Encoding", "x-lzss");
+    StreamConstPtr packedBody(packed, packedSize);
+    httpCode = JSONAPIClient::performStreamRequest(
+      client,
+      request,
+      contentType,
+      packedBody,
+      packedSize,
+      staticJsonResponseBody
+    );
+    request.removeHeader("Content-Encoding");
+  }
+  else {
+    if (debug) {
+      Serial.printf("[HttpStreamBuffered::callHttpApi] Calling API with %d bytes\n", body.size());
+    }
+    // a failed compression attempt consumed the body: start over
+    LogBodyStream plainBody(*batchSource, batchSource->markedSize(), prefix.c_str(), suffix, batchSummary, batchSummaryLength, encoding);
+    httpCode = JSONAPIClient::performStreamRequest(
+      client,
+      request,
+      contentType,
+      plainBody,
+      plainBody.size(),
+      staticJsonResponseBody
+    );
+  }
+  delete[] packed;
 
   if (httpCode != HTTP_CODE_OK) {
     if (debug) {
-      Serial.printf("[HttpStreamBuffered::callHttpApi] url='%s' path='%s' httpCode=%d Response:", 
-                   url.c_str(), path.c_str(), httpCode);
+      Serial.printf("[HttpStreamBuffered::callHttpApi] url='%s' httpCode=%d Response:", 
+                   request.getUrl().c_str(), httpCode);
       serializeJsonPretty(staticJsonResponseBody, Serial);
       Serial.println();
     }
     return false;
   }
 
+  // servers without sequence support do not acknowledge explicitly
+  if (staticJsonResponseBody.containsKey("ack") && staticJsonResponseBody["ack"].as<long>() < (long)batchSeq) {
+    if (debug) {
+      Serial.printf("[HttpStreamBuffered::callHttpApi] batch %d not acknowledged\n", batchSeq);
+    }
+    return false;
+  }
+
   return true;
 }
 
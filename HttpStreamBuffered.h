@@ -2,25 +2,54 @@
 #define STREAMBUFFERED_H
 
 #include <Arduino.h>
-#include "CircularBuffer.hpp"
 
 #include "JSONAPIClient.h"
+#include "LeveledOutput.h"
+#include "LogRecordBuffer.h"
+#include "RtcLogBuffer.h"
+#include "LogSpillQueue.h"
 
 #define CIRCULAR_BUFFER_SIZE 1024
-#define FLUSH_BUFFER_SIZE 256
+#define SUMMARY_BUFFER_SIZE 128
+#define SPILL_SEGMENT_SIZE CIRCULAR_BUFFER_SIZE
+#define COMPRESS_HEAP_RESERVE 8192 // heap left for WiFi/TLS while compressing
 
-class HttpStreamBuffered : public Stream
+class HttpStreamBuffered : public Stream, public LeveledOutput
 {
 protected:
   WiFiClient& client;
-  CircularBuffer<uint8_t, CIRCULAR_BUFFER_SIZE> buffer;
-  boolean overwriting;
+  // level-tagged records: DEBUG/INFO are evicted first when full during an outage
+  LogRecordBuffer records;
+  bool lineOpen = false; // last text write did not end with a newline
   String logId;
-  String url;
-  String path; 
-  String username;
-  String password;
+  PreparedRequest request; // URL, credentials and X-Log-* headers built once
   bool debug;
+  bool binary = false;
+  bool raw = false;
+  bool compress = false;
+  uint32_t compressSkipped = 0; // batches sent uncompressed for lack of heap
+  RtcLogBuffer *rtcTail = nullptr; // unsent records mirrored to RTC memory
+  bool suspended = false;
+  size_t flushWatermark = CIRCULAR_BUFFER_SIZE * 3 / 4;
+  uint32_t flushMaxAgeMillis = 5000;
+  uint32_t pendingSince = 0; // millis() of the oldest unsent write
+
+  // Batch in flight: the marked records plus summary, resent unchanged with
+  // the same sequence number until the server acknowledges it
+  static const uint32_t RETRY_DELAY_MIN_MILLIS = 1000;
+  static const uint32_t RETRY_DELAY_MAX_MILLIS = 60000;
+  char bootId[9];            // random per boot, the server restarts the sequence on change
+  uint32_t batchSeq = 0;
+  bool batchPending = false;
+  char batchSummary[SUMMARY_BUFFER_SIZE];
+  size_t batchSummaryLength = 0;
+  uint32_t retryDelay = 0;   // 0 = no failed attempt
+  uint32_t lastAttempt = 0;
+  LogRecordBuffer *batchSource = &records; // records or replayRecords
+
+  // Overflow while the server is unreachable, replayed oldest first
+  LogSpillQueue *spillQueue = nullptr;
+  LogRecordBuffer *replayRecords = nullptr; // segment in flight, allocated while replaying
 
 public:
   HttpStreamBuffered(WiFiClient& client, const char *logId, const char *url, const char *path, const char *http_username, const char *http_password, bool debug = false);
@@ -28,18 +57,64 @@ public:
 
   size_t write(uint8_t val);
   size_t write(const uint8_t *buf, size_t size);
+  size_t writeLeveled(uint8_t level, const uint8_t *buf, size_t size) override;
+  // Sends everything pending now, blocking: the spilled segments and the records in
+  // RAM, one request per batch, ignoring the retry backoff. Stops at the first failure.
   void flush();
 
+  // Writes only buffer, sending is done by poll() from the main loop: when the
+  // pending data reaches the watermark (bytes) or the oldest of it maxAgeMillis.
+  // When the buffer is full before that, low priority records are evicted.
+  void setFlushPolicy(size_t watermark, uint32_t maxAgeMillis);
+  void poll();
+
+  // Content is a stream of Console binary log records: sent base64 encoded with "format":"binary"
+  void setBinary(bool enable);
+
+  // Content is posted as request body without envelope and encoding, the log id
+  // in the X-Log-Id header (server route /log/raw, use path "/raw")
+  void setRaw(bool enable);
+
+  // Raw batches are LZSS compressed and sent with "Content-Encoding: x-lzss" (see Lzss.h)
+  // JSON batches are never compressed. A batch is sent uncompressed when the heap
+  // cannot hold two copies of it plus the match finder (2 bytes per byte, at most 8 KB)
+  void setCompress(bool enable) { compress = enable; }
+  uint32_t getCompressSkipped() const { return compressSkipped; }
+
+  // Spills records to flash instead of evicting them while sending fails,
+  // they are sent before newer records once the server is reachable again
+  void setSpillQueue(LogSpillQueue *queue) { spillQueue = queue; }
+
+  // Mirrors unsent records to RTC memory. Records kept there before the reset
+  // are queued first and the number of restored records is returned.
+  // The mirror is kept in RAM and written to RTC memory by saveRtcTail(),
+  // setSuspended(true) and after each acknowledged batch, not on every write.
+  size_t setRtcTail(RtcLogBuffer *tail);
+  bool hasRtcTail() const { return rtcTail != nullptr; }
+  // Writes the unsent records to RTC memory, call before a reset or deep sleep
+  void saveRtcTail();
+
+  // While suspended nothing is sent, e.g. before deep sleep: the unsent
+  // records wait in the RTC tail for the next wake instead of a blocking POST.
+  // Records written while suspended are saved to RTC memory at once.
+  void setSuspended(bool enable);
+
+  // Records dropped (evicted or failed to send) by level, not yet reported to the server
+  uint32_t getDroppedRecords(uint8_t level) const { return records.getDropped(level); }
+
    // Stream implementation
   int read();
   int available();
   int peek();
 
 private:
-  void flushBufferedData();
-  bool callHttpApi( const char *data, long dataSize);
-  StaticJsonDocument<0> staticJsonRequestHeader;
-  StaticJsonDocument<CIRCULAR_BUFFER_SIZE + 100> staticJsonRequestBody;
+  bool flushBufferedData();
+  void spillRecords();
+  void rebuildRtcTail();
+  size_t formatDroppedSummary(char *out, size_t size, const uint32_t *dropped);
+  // Posts the current batch with a single request, true if acknowledged
+  bool callHttpApi();
+  StaticJsonDocument<200> staticJsonRequestBody;   // envelope without content
   StaticJsonDocument<100> staticJsonResponseBody;
 };
 
@@ -3,6 +3,63 @@
 #include <ArduinoJson.h>
 
 #include <base64.h>
+#include <new>
+#include <utility>
+
+JSONAPIClient::PooledConnection JSONAPIClient::pool[JSONAPIClient::POOL_SIZE];
+
+PreparedRequest::PreparedRequest(const char *url, const char *path, const char *http_username, const char *http_password)
+    : fullUrl(url), baseLength(fullUrl.length())
+{
+    // scheme://host:port identifies the server of a kept connection
+    int hostStart = fullUrl.indexOf("://");
+    int pathStart = hostStart < 0 ? -1 : fullUrl.indexOf('/', hostStart + 3);
+    origin = pathStart < 0 ? fullUrl : fullUrl.substring(0, pathStart);
+
+    if (http_username && http_password && strlen(http_username) > 0) {
+        String auth = String(http_username) + ":" + String(http_password);
+        authorization = base64::encode(auth, false);
+    }
+    setPath(path);
+}
+
+void PreparedRequest::setPath(const char *path)
+{
+    fullUrl.remove(baseLength);
+    if (path != nullptr) {
+        fullUrl += path;
+    }
+}
+
+bool PreparedRequest::setHeader(const char *name, const char *value)
+{
+    for (uint8_t i = 0; i < headerCount; i++) {
+        if (headerNames[i].equalsIgnoreCase(name)) {
+            headerValues[i] = value;
+            return true;
+        }
+    }
+    if (headerCount == MAX_HEADERS) {
+        return false;
+    }
+    headerNames[headerCount] = name;
+    headerValues[headerCount] = value;
+    headerCount++;
+    return true;
+}
+
+void PreparedRequest::removeHeader(const char *name)
+{
+    for (uint8_t i = 0; i < headerCount; i++) {
+        if (headerNames[i].equalsIgnoreCase(name)) {
+            headerCount--;
+            // keep the storage of the removed header for the next one added
+            std::swap(headerNames[i], headerNames[headerCount]);
+            std::swap(headerValues[i], headerValues[headerCount]);
+            return;
+        }
+    }
+}
 
 int JSONAPIClient::performRequest(
     WiFiClient& client, 
@@ -13,70 +70,116 @@ int JSONAPIClient::performRequest(
     JsonDocument& requestBody, 
     JsonDocument& responseBody,
     const char *http_username, 
-    const char *http_password) 
+    const char *http_password,
+    const JsonDocument *responseFilter) 
 {
     bool debug = false;
-    HTTPClient http;
-    
-    // Build the full URL
-    String fullUrl = String(url) + String(path);
-    
-    if (debug) {
-        Serial.printf("JSONAPIClient::performRequest uri=%s\n", fullUrl.c_str());
+    bool reused = false;
+    PreparedRequest request(url, path, http_username, http_password);
+    HTTPClient *http = beginRequest(client, request, reused, debug);
+    if (http == nullptr) {
+        return HTTP_CODE_HTTP_BEGIN_FAILED;
     }
+    addHeaders(*http, requestHeader, debug);
+    return sendJsonRequest(*http, method, reused, requestBody, responseBody, responseFilter, debug);
+}
 
-    // Use the provided client
-    if (!http.begin(client, fullUrl)) {
-        if (debug) {
-            Serial.println("JSONAPIClient: Failed to begin HTTP connection");
-        }
+int JSONAPIClient::performRequest(
+    WiFiClient& client,
+    int method,
+    const PreparedRequest& request,
+    JsonDocument& requestBody,
+    JsonDocument& responseBody,
+    const JsonDocument *responseFilter)
+{
+    bool debug = false;
+    bool reused = false;
+    HTTPClient *http = beginRequest(client, request, reused, debug);
+    if (http == nullptr) {
         return HTTP_CODE_HTTP_BEGIN_FAILED;
     }
-    
-    // Set basic auth if credentials provided
-    if (http_username && http_password && strlen(http_username) > 0) {
-        String auth = String(http_username) + ":" + String(http_password);
-        String encodedAuth = base64::encode(auth);
-        http.setAuthorization(encodedAuth);
+    return sendJsonRequest(*http, method, reused, requestBody, responseBody, responseFilter, debug);
+}
+
+int JSONAPIClient::performStreamRequest(
+    WiFiClient& client,
+    const char *url,
+    const char *path,
+    JsonDocument& requestHeader,
+    const char *contentType,
+    Stream& requestBody,
+    size_t requestBodySize,
+    JsonDocument& responseBody,
+    const char *http_username,
+    const char *http_password)
+{
+    bool debug = false;
+    bool reused = false;
+    PreparedRequest request(url, path, http_username, http_password);
+    HTTPClient *http = beginRequest(client, request, reused, debug);
+    if (http == nullptr) {
+        return HTTP_CODE_HTTP_BEGIN_FAILED;
     }
-    
-    // Add custom headers from requestHeader JSON document
-    for (JsonPair kv : requestHeader.as<JsonObject>()) {
-        const char* headerName = kv.key().c_str();
-        const char* headerValue = kv.value().as<const char*>();
-        if (headerName && headerValue) {
-            http.addHeader(headerName, headerValue);
-            if (debug) {
-                Serial.printf("JSONAPIClient:: Added header: %s: %s\n", headerName, headerValue);
-            }
-        }
+    addHeaders(*http, requestHeader, debug);
+    return sendStreamRequest(*http, contentType, requestBody, requestBodySize, responseBody, debug);
+}
+
+int JSONAPIClient::performStreamRequest(
+    WiFiClient& client,
+    const PreparedRequest& request,
+    const char *contentType,
+    Stream& requestBody,
+    size_t requestBodySize,
+    JsonDocument& responseBody)
+{
+    bool debug = false;
+    bool reused = false;
+    HTTPClient *http = beginRequest(client, request, reused, debug);
+    if (http == nullptr) {
+        return HTTP_CODE_HTTP_BEGIN_FAILED;
     }
-    
+    return sendStreamRequest(*http, contentType, requestBody, requestBodySize, responseBody, debug);
+}
+
+int JSONAPIClient::sendJsonRequest(HTTPClient& http, int method, bool reused, JsonDocument& requestBody, JsonDocument& responseBody,
+                                   const JsonDocument *responseFilter, bool debug)
+{
     // Set content type header
     http.addHeader("Content-Type", "application/json");
-    // Add keep-alive header to maintain persistent connection
-    http.addHeader("Connection", "keep-alive");
     
     int httpCode = 0;
-    String requestBodyStr;
     
     // Send the request
     switch (method) {
         case HTTP_METHOD_GET:
             httpCode = http.GET();
+            if (reused && (httpCode == HTTPC_ERROR_SEND_HEADER_FAILED || httpCode == HTTPC_ERROR_CONNECTION_LOST)) {
+                // the server closed the kept connection meanwhile: a GET can be repeated on a new one
+                if (debug) {
+                    Serial.println("JSONAPIClient: Kept connection lost, retrying");
+                }
+                httpCode = http.GET(); // HTTPClient stopped the broken connection and connects again
+            }
             break;
             
         case HTTP_METHOD_POST: {
-            int requestBodySize = serializeJson(requestBody, requestBodyStr);
-            if (requestBodySize > 0) {
-                http.addHeader("Content-Length", String(requestBodyStr.length()));
+            // Serialized once into a buffer of the measured size instead of a String grown
+            // while serializing: small bodies on the stack, larger ones with one allocation
+            size_t requestBodySize = measureJson(requestBody);
+            char stackBody[STACK_BODY_SIZE];
+            char *body = requestBodySize < sizeof(stackBody) ? stackBody : new (std::nothrow) char[requestBodySize + 1];
+            if (requestBodySize > 0 && body != nullptr && serializeJson(requestBody, body, requestBodySize + 1) == requestBodySize) {
                 if (debug) {
-                    Serial.printf("JSONAPIClient:: Sending request body: %s\n", requestBodyStr.c_str());
+                    Serial.printf("JSONAPIClient:: Sending request body: %s\n", body);
                 }
-                httpCode = http.POST(requestBodyStr);
+                // HTTPClient sets Content-Length and writes the body with one call
+                httpCode = http.sendRequest("POST", reinterpret_cast<const uint8_t *>(body), requestBodySize);
             } else {
                 httpCode = HTTP_CODE_SERIALIZE_REQUESTBODY_FAILED;
             }
+            if (body != stackBody) {
+                delete[] body;
+            }
             break;
         }
             
@@ -88,12 +191,125 @@ int JSONAPIClient::performRequest(
             return HTTP_CODE_UNSUPPORTED_HTTP_METHOD;
     }
     
+    return handleResponse(http, httpCode, responseBody, responseFilter, debug);
+}
+
+int JSONAPIClient::sendStreamRequest(HTTPClient& http, const char *contentType, Stream& requestBody, size_t requestBodySize,
+                                     JsonDocument& responseBody, bool debug)
+{
+    http.addHeader("Content-Type", contentType);
+
+    if (debug) {
+        Serial.printf("JSONAPIClient:: Streaming request body of %d bytes\n", requestBodySize);
+    }
+    // HTTPClient sets Content-Length and pulls the body from the stream
+    int httpCode = http.sendRequest("POST", &requestBody, requestBodySize);
+
+    return handleResponse(http, httpCode, responseBody, nullptr, debug);
+}
+
+void JSONAPIClient::closeConnections()
+{
+    for (uint8_t i = 0; i < POOL_SIZE; i++) {
+        closeConnection(pool[i]);
+    }
+}
+
+void JSONAPIClient::closeConnection(PooledConnection& connection)
+{
+    if (connection.client == nullptr) {
+        return;
+    }
+    // end() only closes a connection that is not kept for reuse
+    connection.http.setReuse(false);
+    connection.http.end();
+    connection.client = nullptr;
+    connection.origin = "";
+}
+
+// Returns the pooled HTTPClient of the socket prepared for the request, nullptr on failure.
+// reused is set if the request goes over a connection kept from a previous one.
+HTTPClient* JSONAPIClient::beginRequest(WiFiClient& client, const PreparedRequest& request, bool& reused, bool debug)
+{
+    if (debug) {
+        Serial.printf("JSONAPIClient::performRequest uri=%s\n", request.fullUrl.c_str());
+    }
+
+    PooledConnection *connection = nullptr;
+    PooledConnection *oldest = &pool[0];
+    for (uint8_t i = 0; i < POOL_SIZE; i++) {
+        PooledConnection& candidate = pool[i];
+        if (candidate.client != nullptr && (unsigned long)(millis() - candidate.lastUsed) > POOL_IDLE_TIMEOUT_MILLIS) {
+            closeConnection(candidate); // the server may have dropped it already
+        }
+        if (candidate.client == &client) {
+            connection = &candidate;
+        }
+        if (oldest->client != nullptr && (candidate.client == nullptr || candidate.lastUsed < oldest->lastUsed)) {
+            oldest = &candidate;
+        }
+    }
+    if (connection == nullptr) {
+        connection = oldest;
+    }
+
+    HTTPClient& http = connection->http;
+    reused = connection->client == &client && connection->origin == request.origin && http.connected();
+    if (reused) {
+        // same server: keep the connection, only the URL changes
+        if (!http.setURL(request.fullUrl)) {
+            closeConnection(*connection);
+            return nullptr;
+        }
+    } else {
+        // a socket connects to one server at a time
+        closeConnection(*connection);
+        if (!http.begin(client, request.fullUrl)) {
+            if (debug) {
+                Serial.println("JSONAPIClient: Failed to begin HTTP connection");
+            }
+            return nullptr;
+        }
+        connection->client = &client;
+        connection->origin = request.origin;
+    }
+    http.setReuse(true);
+    connection->lastUsed = millis();
+    
+    // basic auth if credentials provided, the pooled client may still hold another one
+    http.setAuthorization(request.authorization.c_str());
+    for (uint8_t i = 0; i < request.headerCount; i++) {
+        http.addHeader(request.headerNames[i], request.headerValues[i]);
+    }
+    return &http;
+}
+
+// Add custom headers from requestHeader JSON document
+void JSONAPIClient::addHeaders(HTTPClient& http, JsonDocument& requestHeader, bool debug)
+{
+    for (JsonPair kv : requestHeader.as<JsonObject>()) {
+        const char* headerName = kv.key().c_str();
+        const char* headerValue = kv.value().as<const char*>();
+        if (headerName && headerValue) {
+            http.addHeader(headerName, headerValue);
+            if (debug) {
+                Serial.printf("JSONAPIClient:: Added header: %s: %s\n", headerName, headerValue);
+            }
+        }
+    }
+}
+
+int JSONAPIClient::handleResponse(HTTPClient& http, int httpCode, JsonDocument& responseBody, const JsonDocument *responseFilter, bool debug)
+{
     // Handle the response
     if (httpCode > 0) {
         if (httpCode == HTTP_CODE_OK) {
-            // Deserialize directly from the HTTP stream to avoid duplicating the payload into a String
+            // Deserialize directly from the HTTP stream to avoid duplicating the payload into a String.
+            // With a filter the fields not selected are skipped while parsing and take no space in responseBody.
             WiFiClient& stream = http.getStream();
-            DeserializationError error = deserializeJson(responseBody, stream);
+            DeserializationError error = responseFilter != nullptr
+                ? deserializeJson(responseBody, stream, DeserializationOption::Filter(*responseFilter))
+                : deserializeJson(responseBody, stream);
             if (error) {
                 if (debug) {
                     Serial.print("JSONAPIClient: Failed to parse JSON from stream: ");
@@ -6,6 +6,36 @@
 #include <WiFiClient.h>
 #include <WiFiClientSecure.h>
 
+// Target of requests repeated with the same URL and credentials, e.g. each log
+// flush: the full URL, the server origin and the base64 Authorization value are
+// built once, the headers are kept in place. Changing a header value between calls
+// (e.g. a sequence number) reuses its storage.
+class PreparedRequest {
+public:
+    static const uint8_t MAX_HEADERS = 6;
+
+    PreparedRequest(const char *url, const char *path = "", const char *http_username = nullptr, const char *http_password = nullptr);
+
+    // Replaces the path (and query) after the base url
+    void setPath(const char *path);
+    // Adds a header sent with every request or replaces its value, false if MAX_HEADERS are used
+    bool setHeader(const char *name, const char *value);
+    void removeHeader(const char *name);
+
+    const String& getUrl() const { return fullUrl; }
+
+private:
+    friend class JSONAPIClient;
+
+    String fullUrl;
+    size_t baseLength; // length of the url before the path
+    String origin;     // scheme://host:port, identifies a kept connection
+    String authorization; // base64 username:password, empty without credentials
+    String headerNames[MAX_HEADERS];
+    String headerValues[MAX_HEADERS];
+    uint8_t headerCount = 0;
+};
+
 class JSONAPIClient {
 public:   
     static const int HTTP_CODE_HTTP_BEGIN_FAILED = -1;
@@ -17,7 +47,8 @@ public:
     static const int HTTP_METHOD_GET = 1;
     static const int HTTP_METHOD_POST = 2;
 
-    // Main request method
+    // Main request method. With a responseFilter (ArduinoJson filter document, e.g.
+    // filter["dtnow"] = true) only the selected fields are stored in responseBody.
     static int performRequest(
         WiFiClient& client, 
         int method, 
@@ -27,8 +58,71 @@ public:
         JsonDocument& requestBody, 
         JsonDocument& responseBody,
         const char *http_username = nullptr, 
+        const char *http_password = nullptr,
+        const JsonDocument *responseFilter = nullptr
+    );
+
+    // POST with a body read from a stream of known size, e.g. generated on the fly
+    static int performStreamRequest(
+        WiFiClient& client,
+        const char *url,
+        const char *path,
+        JsonDocument& requestHeader,
+        const char *contentType,
+        Stream& requestBody,
+        size_t requestBodySize,
+        JsonDocument& responseBody,
+        const char *http_username = nullptr,
         const char *http_password = nullptr
     );
+
+    // Same as above for a prepared URL, credentials and headers
+    static int performRequest(
+        WiFiClient& client,
+        int method,
+        const PreparedRequest& request,
+        JsonDocument& requestBody,
+        JsonDocument& responseBody,
+        const JsonDocument *responseFilter = nullptr
+    );
+    static int performStreamRequest(
+        WiFiClient& client,
+        const PreparedRequest& request,
+        const char *contentType,
+        Stream& requestBody,
+        size_t requestBodySize,
+        JsonDocument& responseBody
+    );
+
+    // Closes the kept connections, e.g. before deep sleep or when WiFi is lost
+    static void closeConnections();
+
+private:
+    // HTTPClient kept per socket (see ManageWifiClient) so its connection is
+    // reused by the next request to the same host. Closed when idle for longer
+    // than POOL_IDLE_TIMEOUT_MILLIS (below common server keep-alive timeouts),
+    // when the socket is used for another host or when the server closed it.
+    struct PooledConnection {
+        HTTPClient http;
+        WiFiClient *client = nullptr;
+        String origin; // scheme://host:port of the connection
+        uint32_t lastUsed = 0;
+    };
+    // JSON request bodies below this size are serialized on the stack
+    static const size_t STACK_BODY_SIZE = 256;
+
+    static const uint8_t POOL_SIZE = 2; // plain and TLS socket
+    static const uint32_t POOL_IDLE_TIMEOUT_MILLIS = 4000;
+    static PooledConnection pool[POOL_SIZE];
+
+    static void closeConnection(PooledConnection& connection);
+    static HTTPClient* beginRequest(WiFiClient& client, const PreparedRequest& request, bool& reused, bool debug);
+    static void addHeaders(HTTPClient& http, JsonDocument& requestHeader, bool debug);
+    static int sendJsonRequest(HTTPClient& http, int method, bool reused, JsonDocument& requestBody, JsonDocument& responseBody,
+                               const JsonDocument *responseFilter, bool debug);
+    static int sendStreamRequest(HTTPClient& http, const char *contentType, Stream& requestBody, size_t requestBodySize,
+                                 JsonDocument& responseBody, bool debug);
+    static int handleResponse(HTTPClient& http, int httpCode, JsonDocument& responseBody, const JsonDocument *responseFilter, bool debug);
 };
 
 #endif // HTTPREST_H
\ No newline at end of file
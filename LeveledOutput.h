@@ -0,0 +1,20 @@
+#ifndef LEVELEDOUTPUT_H
+#define LEVELEDOUTPUT_H
+
+#include <Arduino.h>
+
+// Interface for log sinks that keep the log level of the data written to them,
+// e.g. to evict low priority data first when their buffer is full. Console
+// calls writeLeveled() instead of write() for sinks registered with a
+// LeveledOutput (see Console::addSink).
+class LeveledOutput
+{
+public:
+  // Level used for data written through the plain Stream interface
+  static const uint8_t DEFAULT_LEVEL = 20; // Console::INFO
+
+  virtual ~LeveledOutput() {}
+  virtual size_t writeLeveled(uint8_t level, const uint8_t *buf, size_t size) = 0;
+};
+
+#endif // LEVELEDOUTPUT_H
@@ -0,0 +1,194 @@
+#include "LogBodyStream.h"
+
+static const char HEX_DIGITS[] = "0123456789ABCDEF";
+static const char BASE64_DIGITS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+LogBodyStream::LogBodyStream(const LogRecordBuffer &records, size_t end, const char *prefix, const char *suffix,
+                             const char *summary, size_t summaryLength, Encoding encoding)
+  : records(records), end(end), prefix(prefix), suffix(suffix), summary(summary), summaryLength(summaryLength), encoding(encoding)
+{
+  size_t payloadSize = summaryLength;
+  size_t urlEncodedSize = 0;
+  for (size_t i = 0; i < summaryLength; i++)
+    urlEncodedSize += isUnreserved(summary[i]) ? 1 : 3;
+  records.forEach([&payloadSize, &urlEncodedSize, encoding](uint8_t, const uint8_t *data, size_t length) {
+    payloadSize += length;
+    if (encoding == ENCODING_URL)
+      for (size_t i = 0; i < length; i++)
+        urlEncodedSize += isUnreserved(data[i]) ? 1 : 3;
+  }, end);
+
+  size_t contentSize = payloadSize;
+  if (encoding == ENCODING_BASE64)
+    contentSize = (payloadSize + 2) / 3 * 4;
+  else if (encoding == ENCODING_URL)
+    contentSize = urlEncodedSize;
+  bodySize = strlen(prefix) + contentSize + strlen(suffix);
+}
+
+bool LogBodyStream::isUnreserved(uint8_t c)
+{
+  return isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~';
+}
+
+// Summary first, then the record payloads
+size_t LogBodyStream::readRaw(uint8_t *out, size_t maxSize)
+{
+  size_t copied = 0;
+  if (summaryPosition < summaryLength)
+  {
+    copied = summaryLength - summaryPosition;
+    if (copied > maxSize)
+      copied = maxSize;
+    memcpy(out, summary + summaryPosition, copied);
+    summaryPosition += copied;
+  }
+  return copied + records.peek(cursor, out + copied, maxSize - copied, end);
+}
+
+size_t LogBodyStream::encode(const uint8_t *raw, size_t length)
+{
+  size_t out = 0;
+  if (encoding == ENCODING_BASE64)
+  {
+    for (size_t i = 0; i < length; i += 3)
+    {
+      uint32_t group = raw[i] << 16;
+      if (i + 1 < length)
+        group |= raw[i + 1] << 8;
+      if (i + 2 < length)
+        group |= raw[i + 2];
+      encoded[out++] = BASE64_DIGITS[(group >> 18) & 0x3F];
+      encoded[out++] = BASE64_DIGITS[(group >> 12) & 0x3F];
+      encoded[out++] = i + 1 < length ? BASE64_DIGITS[(group >> 6) & 0x3F] : '=';
+      encoded[out++] = i + 2 < length ? BASE64_DIGITS[group & 0x3F] : '=';
+    }
+  }
+  else
+  {
+    for (size_t i = 0; i < length; i++)
+    {
+      if (isUnreserved(raw[i]))
+      {
+        encoded[out++] = raw[i];
+      }
+      else
+      {
+        encoded[out++] = '%';
+        encoded[out++] = HEX_DIGITS[raw[i] >> 4];
+        encoded[out++] = HEX_DIGITS[raw[i] & 0x0F];
+      }
+    }
+  }
+  return out;
+}
+
+// Makes the next piece of output current, false at the end of the body
+bool LogBodyStream::fill()
+{
+  while (chunkPosition >= chunkLength)
+  {
+    chunkPosition = 0;
+    switch (phase)
+    {
+    case PHASE_PREFIX:
+      chunk = reinterpret_cast<const uint8_t *>(prefix);
+      chunkLength = strlen(prefix);
+      phase = PHASE_CONTENT;
+      break;
+    case PHASE_CONTENT:
+    {
+      if (encoding == ENCODING_NONE)
+      {
+        // zero-copy: the summary and the record payloads are sent in place
+        if (summaryPosition < summaryLength)
+        {
+          chunk = reinterpret_cast<const uint8_t *>(summary) + summaryPosition;
+          chunkLength = summaryLength - summaryPosition;
+          summaryPosition = summaryLength;
+        }
+        else
+        {
+          chunkLength = records.span(cursor, chunk, end);
+          records.skip(cursor, chunkLength);
+        }
+      }
+      else
+      {
+        chunk = encoded;
+        // whole base64 groups except at the very end
+        uint8_t raw[RAW_CHUNK_SIZE];
+        chunkLength = encode(raw, readRaw(raw, sizeof(raw)));
+      }
+      if (chunkLength == 0)
+        phase = PHASE_SUFFIX;
+      break;
+    }
+    case PHASE_SUFFIX:
+      chunk = reinterpret_cast<const uint8_t *>(suffix);
+      chunkLength = strlen(suffix);
+      phase = PHASE_DONE;
+      break;
+    default:
+      chunkLength = 0;
+      return false;
+    }
+  }
+  return true;
+}
+
+int LogBodyStream::available()
+{
+  return bodySize - sent;
+}
+
+int LogBodyStream::read()
+{
+  if (!fill())
+    return -1;
+  sent++;
+  return chunk[chunkPosition++];
+}
+
+int LogBodyStream::read(uint8_t *buffer, size_t size)
+{
+  size_t copied = 0;
+  while (copied < size && fill())
+  {
+    size_t length = chunkLength - chunkPosition;
+    if (length > size - copied)
+      length = size - copied;
+    memcpy(buffer + copied, chunk + chunkPosition, length);
+    chunkPosition += length;
+    copied += length;
+  }
+  sent += copied;
+  return copied;
+}
+
+int LogBodyStream::peek()
+{
+  if (!fill())
+    return -1;
+  return chunk[chunkPosition];
+}
+
+size_t LogBodyStream::peekAvailable()
+{
+  if (!fill())
+    return 0;
+  return chunkLength - chunkPosition;
+}
+
+const char *LogBodyStream::peekBuffer()
+{
+  if (!fill())
+    return nullptr;
+  return reinterpret_cast<const char *>(chunk + chunkPosition);
+}
+
+void LogBodyStream::peekConsume(size_t consume)
+{
+  chunkPosition += consume;
+  sent += consume;
+}
@@ -0,0 +1,84 @@
+#ifndef LOGBODYSTREAM_H
+#define LOGBODYSTREAM_H
+
+#include <Arduino.h>
+
+#include "LogRecordBuffer.h"
+
+// Request body for the log server produced on the fly from a LogRecordBuffer:
+// prefix + encoded(summary + record payloads before end) + suffix
+// For the JSON envelope the prefix is its start up to the opening quote of the
+// content value and the suffix closes it, for raw bodies both are empty.
+// HTTPClient pulls the body in TCP sized pieces, so the whole
+// buffer is sent with one request without building the encoded body in RAM.
+// The record buffer must not change until the body has been sent.
+class LogBodyStream : public Stream
+{
+public:
+  enum Encoding : uint8_t
+  {
+    ENCODING_NONE,  // raw bytes
+    ENCODING_URL,   // compatible with urlEncode()
+    ENCODING_BASE64 // standard alphabet with padding, no line breaks
+  };
+
+  LogBodyStream(const LogRecordBuffer &records, size_t end, const char *prefix, const char *suffix,
+                const char *summary, size_t summaryLength, Encoding encoding);
+
+  // Total body size, for the Content-Length header
+  size_t size() const { return bodySize; }
+
+  int available() override;
+  int read() override;
+  int read(uint8_t *buffer, size_t size) override;
+  int peek() override;
+  size_t write(uint8_t) override { return 0; }
+
+  // Peek buffer API: the sender reads each piece in place, raw record payloads
+  // directly from the record buffer
+  bool hasPeekBufferAPI() const override { return true; }
+  size_t peekAvailable() override;
+  const char *peekBuffer() override;
+  void peekConsume(size_t consume) override;
+  bool inputCanTimeout() override { return false; } // everything is available
+  ssize_t streamRemaining() override { return bodySize - sent; }
+
+private:
+  enum Phase : uint8_t
+  {
+    PHASE_PREFIX,
+    PHASE_CONTENT,
+    PHASE_SUFFIX,
+    PHASE_DONE
+  };
+
+  // raw bytes encoded per step: 16 * 3 bytes become 64 base64 or at most 48 * 3 url encoded characters
+  static const size_t RAW_CHUNK_SIZE = 48;
+
+  const LogRecordBuffer &records;
+  LogRecordBuffer::Cursor cursor;
+  size_t end;
+  const char *prefix;
+  const char *suffix;
+  const char *summary;
+  size_t summaryLength;
+  size_t summaryPosition = 0;
+  Encoding encoding;
+
+  size_t bodySize;
+  size_t sent = 0;
+  Phase phase = PHASE_PREFIX;
+
+  // current piece of output: prefix, encoded content or suffix
+  const uint8_t *chunk = nullptr;
+  size_t chunkLength = 0;
+  size_t chunkPosition = 0;
+  uint8_t encoded[RAW_CHUNK_SIZE * 3];
+
+  bool fill();
+  size_t readRaw(uint8_t *out, size_t maxSize);
+  size_t encode(const uint8_t *raw, size_t length);
+  static bool isUnreserved(uint8_t c);
+};
+
+#endif // LOGBODYSTREAM_H
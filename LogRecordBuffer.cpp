@@ -0,0 +1,279 @@
+#include "LogRecordBuffer.h"
+
+LogRecordBuffer::LogRecordBuffer(size_t capacity) : capacity(capacity)
+{
+  buffer = new uint8_t[capacity];
+}
+
+LogRecordBuffer::~LogRecordBuffer()
+{
+  delete[] buffer;
+}
+
+uint8_t LogRecordBuffer::levelIndex(uint8_t level)
+{
+  // 10 (DEBUG) ... 50 (CRITICAL)
+  if (level < 10)
+    return 0;
+  if (level >= 10 * LEVEL_COUNT)
+    return LEVEL_COUNT - 1;
+  return level / 10 - 1;
+}
+
+size_t LogRecordBuffer::recordLength(size_t offset) const
+{
+  return buffer[offset + 1] | (buffer[offset + 2] << 8);
+}
+
+size_t LogRecordBuffer::write(uint8_t level, const uint8_t *data, size_t size, bool merge)
+{
+  if (size == 0)
+    return 0;
+
+  // append to the newest record
+  if (merge && records > 0 && buffer[lastRecord] == level && lastRecord >= markedEnd)
+  {
+    size_t length = recordLength(lastRecord);
+    if (length + size <= 0xFFFF && size <= available())
+    {
+      memcpy(buffer + used, data, size);
+      used += size;
+      length += size;
+      buffer[lastRecord + 1] = (uint8_t)length;
+      buffer[lastRecord + 2] = (uint8_t)(length >> 8);
+      return size;
+    }
+  }
+
+  // a record larger than the whole buffer is truncated
+  size_t stored = size;
+  if (stored > capacity - HEADER_SIZE)
+    stored = capacity - HEADER_SIZE;
+  if (stored > 0xFFFF)
+    stored = 0xFFFF;
+
+  while (available() < HEADER_SIZE + stored)
+  {
+    if (!evict(level))
+    {
+      countDropped(level);
+      return 0;
+    }
+  }
+
+  lastRecord = used;
+  buffer[used] = level;
+  buffer[used + 1] = (uint8_t)stored;
+  buffer[used + 2] = (uint8_t)(stored >> 8);
+  memcpy(buffer + used + HEADER_SIZE, data, stored);
+  used += HEADER_SIZE + stored;
+  records++;
+  return stored;
+}
+
+uint8_t *LogRecordBuffer::append(uint8_t level, size_t size)
+{
+  if (size == 0 || size > 0xFFFF || available() < HEADER_SIZE + size)
+    return nullptr;
+
+  lastRecord = used;
+  buffer[used] = level;
+  buffer[used + 1] = (uint8_t)size;
+  buffer[used + 2] = (uint8_t)(size >> 8);
+  used += HEADER_SIZE + size;
+  records++;
+  return buffer + lastRecord + HEADER_SIZE;
+}
+
+void LogRecordBuffer::truncate(size_t end)
+{
+  if (end >= used)
+    return;
+
+  // end must be a record boundary
+  records = 0;
+  lastRecord = 0;
+  for (size_t offset = 0; offset < end; offset += HEADER_SIZE + recordLength(offset))
+  {
+    lastRecord = offset;
+    records++;
+  }
+  used = end;
+  if (markedEnd > used)
+    markedEnd = used;
+}
+
+// Removes the oldest record of the lowest level, if that level is not above level
+bool LogRecordBuffer::evict(uint8_t level)
+{
+  size_t victim = used;
+  uint8_t victimLevel = 0xFF;
+  for (size_t offset = 0; offset < used; offset += HEADER_SIZE + recordLength(offset))
+  {
+    if (buffer[offset] < victimLevel)
+    {
+      victim = offset;
+      victimLevel = buffer[offset];
+    }
+  }
+
+  if (victim == used || victimLevel > level)
+    return false;
+
+  countDropped(victimLevel);
+  remove(victim);
+  return true;
+}
+
+void LogRecordBuffer::remove(size_t offset)
+{
+  size_t length = HEADER_SIZE + recordLength(offset);
+  memmove(buffer + offset, buffer + offset + length, used - offset - length);
+  used -= length;
+  records--;
+  if (offset < markedEnd)
+    markedEnd -= length;
+  if (lastRecord > offset)
+    lastRecord -= length;
+  else if (lastRecord == offset)
+  {
+    // removed the newest record: find the one before it
+    lastRecord = 0;
+    for (size_t next = 0; next < used; next += HEADER_SIZE + recordLength(next))
+      lastRecord = next;
+  }
+}
+
+size_t LogRecordBuffer::read(uint8_t *out, size_t maxSize, uint32_t *levelCounts)
+{
+  size_t copied = 0;
+  size_t offset = 0;
+  while (offset < used && copied < maxSize)
+  {
+    size_t length = recordLength(offset);
+    size_t chunk = length;
+    if (chunk > maxSize - copied)
+      chunk = maxSize - copied;
+    if (out != nullptr)
+      memcpy(out + copied, buffer + offset + HEADER_SIZE, chunk);
+    copied += chunk;
+
+    if (chunk < length)
+    {
+      // keep the header for the remaining payload, directly before it
+      size_t remaining = length - chunk;
+      uint8_t level = buffer[offset];
+      offset += chunk;
+      buffer[offset] = level;
+      buffer[offset + 1] = (uint8_t)remaining;
+      buffer[offset + 2] = (uint8_t)(remaining >> 8);
+      break;
+    }
+    if (levelCounts != nullptr)
+      levelCounts[levelIndex(buffer[offset])]++;
+    offset += HEADER_SIZE + length;
+    records--;
+  }
+
+  memmove(buffer, buffer + offset, used - offset);
+  used -= offset;
+  markedEnd = markedEnd > offset ? markedEnd - offset : 0;
+  if (lastRecord >= offset)
+    lastRecord -= offset;
+  else
+    lastRecord = 0;
+  return copied;
+}
+
+size_t LogRecordBuffer::peek(Cursor &cursor, uint8_t *out, size_t maxSize, size_t end) const
+{
+  size_t copied = 0;
+  const uint8_t *data;
+  size_t length;
+  while (copied < maxSize && (length = span(cursor, data, end)) > 0)
+  {
+    if (length > maxSize - copied)
+      length = maxSize - copied;
+    memcpy(out + copied, data, length);
+    skip(cursor, length);
+    copied += length;
+  }
+  return copied;
+}
+
+size_t LogRecordBuffer::span(const Cursor &cursor, const uint8_t *&data, size_t end) const
+{
+  if (end > used)
+    end = used;
+  // skip empty records
+  Cursor next = cursor;
+  while (next.offset < end && next.position == recordLength(next.offset))
+  {
+    next.offset += HEADER_SIZE + recordLength(next.offset);
+    next.position = 0;
+  }
+  if (next.offset >= end)
+    return 0;
+
+  data = buffer + next.offset + HEADER_SIZE + next.position;
+  return recordLength(next.offset) - next.position;
+}
+
+void LogRecordBuffer::skip(Cursor &cursor, size_t size) const
+{
+  while (cursor.offset < used && size > 0)
+  {
+    size_t length = recordLength(cursor.offset);
+    size_t chunk = length - cursor.position;
+    if (chunk > size)
+      chunk = size;
+    cursor.position += chunk;
+    size -= chunk;
+    if (cursor.position == length)
+    {
+      cursor.offset += HEADER_SIZE + length;
+      cursor.position = 0;
+    }
+  }
+}
+
+void LogRecordBuffer::clear()
+{
+  used = 0;
+  records = 0;
+  lastRecord = 0;
+  markedEnd = 0;
+}
+
+void LogRecordBuffer::removeMarked()
+{
+  size_t count = 0;
+  forEach([&count](uint8_t, const uint8_t *, size_t) { count++; }, markedEnd);
+
+  memmove(buffer, buffer + markedEnd, used - markedEnd);
+  used -= markedEnd;
+  records -= count;
+  lastRecord = lastRecord >= markedEnd ? lastRecord - markedEnd : 0;
+  markedEnd = 0;
+}
+
+bool LogRecordBuffer::hasDropped() const
+{
+  for (uint8_t i = 0; i < LEVEL_COUNT; i++)
+    if (dropped[i] != 0)
+      return true;
+  return false;
+}
+
+void LogRecordBuffer::clearDropped()
+{
+  memset(dropped, 0, sizeof(dropped));
+}
+
+bool LogRecordBuffer::takeDropped(uint32_t *counts)
+{
+  memcpy(counts, dropped, sizeof(dropped));
+  bool any = hasDropped();
+  clearDropped();
+  return any;
+}
@@ -0,0 +1,103 @@
+#ifndef LOGRECORDBUFFER_H
+#define LOGRECORDBUFFER_H
+
+#include <Arduino.h>
+
+// Buffer of level-tagged log records: level(1) length(2) payload.
+// When full, the oldest record of the lowest level is evicted first, so
+// DEBUG/INFO data makes room for WARNING/ERROR/CRITICAL but never the reverse.
+// Dropped records are counted per level.
+class LogRecordBuffer
+{
+public:
+  static const size_t HEADER_SIZE = 3;
+  static const uint8_t LEVEL_COUNT = 5; // DEBUG, INFO, WARNING, ERROR, CRITICAL
+
+  LogRecordBuffer(size_t capacity);
+  ~LogRecordBuffer();
+
+  // Stores a record, evicting lower or equal level records if required.
+  // Returns the payload bytes stored: size, less if a record larger than the buffer
+  // was truncated, or 0 if it was dropped because only higher levels are buffered.
+  // With merge the payload is appended to the newest record if it has the same level.
+  size_t write(uint8_t level, const uint8_t *data, size_t size, bool merge = false);
+
+  // Appends a record of size bytes without evicting and returns its payload
+  // to be filled in, nullptr if there is not enough space
+  uint8_t *append(uint8_t level, size_t size);
+
+  // Removes all records from offset end on, e.g. those after the marked ones
+  void truncate(size_t end);
+
+  // Copies up to maxSize payload bytes of the oldest records to out and removes them,
+  // out may be nullptr to only remove them (e.g. after sending them from a peek()).
+  // A partially read record stays in the buffer with its remaining payload.
+  // levelCounts (LEVEL_COUNT entries) is incremented for each record read completely.
+  size_t read(uint8_t *out, size_t maxSize, uint32_t *levelCounts = nullptr);
+
+  // Position of a non-destructive reader, see peek()
+  struct Cursor
+  {
+    size_t offset = 0;   // record header offset
+    size_t position = 0; // payload bytes of that record already read
+  };
+
+  // Copies up to maxSize payload bytes from cursor on without removing them,
+  // only from records before end (byte offset, e.g. markedSize()).
+  // The buffer must not be modified while a cursor is in use.
+  size_t peek(Cursor &cursor, uint8_t *out, size_t maxSize, size_t end = SIZE_MAX) const;
+
+  // Zero-copy read: points data at the contiguous payload at cursor (the rest of
+  // one record, at most two spans per record after a partial read) and returns
+  // its length, 0 at end. Call skip() with the bytes used to advance.
+  size_t span(const Cursor &cursor, const uint8_t *&data, size_t end = SIZE_MAX) const;
+  void skip(Cursor &cursor, size_t size) const;
+
+  // Marks the records currently buffered, e.g. as a batch in flight. Evicting
+  // a marked record shrinks the marked range, new records are never merged into it.
+  void mark() { markedEnd = used; }
+  size_t markedSize() const { return markedEnd; } // bytes including headers
+  void removeMarked();
+
+  size_t size() const { return used; }                     // bytes used including headers
+  size_t available() const { return capacity - used; }    // bytes free including headers
+  size_t payloadSize() const { return used - records * HEADER_SIZE; }
+  size_t recordCount() const { return records; }
+  bool isEmpty() const { return used == 0; }
+  void clear();
+
+  // Records dropped since the last clearDropped(), by level
+  uint32_t getDropped(uint8_t level) const { return dropped[levelIndex(level)]; }
+  bool hasDropped() const;
+  void countDropped(uint8_t level, uint32_t count = 1) { dropped[levelIndex(level)] += count; }
+  void clearDropped();
+  // Copies the dropped counters to counts (LEVEL_COUNT entries) and clears them
+  bool takeDropped(uint32_t *counts);
+
+  // Calls visit(level, payload, length) for every record before end, oldest first
+  template <typename Visitor>
+  void forEach(Visitor visit, size_t end = SIZE_MAX) const
+  {
+    if (end > used)
+      end = used;
+    for (size_t offset = 0; offset < end; offset += HEADER_SIZE + recordLength(offset))
+      visit(buffer[offset], buffer + offset + HEADER_SIZE, recordLength(offset));
+  }
+
+  static uint8_t levelIndex(uint8_t level);
+
+protected:
+  uint8_t *buffer;
+  size_t capacity;
+  size_t used = 0;
+  size_t records = 0;
+  size_t lastRecord = 0; // offset of the newest record
+  size_t markedEnd = 0;  // end of the marked records
+  uint32_t dropped[LEVEL_COUNT] = {};
+
+  size_t recordLength(size_t offset) const;
+  bool evict(uint8_t level);
+  void remove(size_t offset);
+};
+
+#endif // LOGRECORDBUFFER_H
@@ -0,0 +1,163 @@
+#include "LogSpillQueue.h"
+#include <LittleFS.h>
+
+LogSpillQueue::LogSpillQueue(const char *directory, size_t segmentSize, uint16_t maxSegments)
+  : directory(directory), segmentSize(segmentSize), maxSegments(maxSegments)
+{
+}
+
+String LogSpillQueue::segmentPath(uint32_t segment) const
+{
+  return directory + "/" + String(segment) + ".seg";
+}
+
+bool LogSpillQueue::begin()
+{
+  if (!LittleFS.exists(directory) && !LittleFS.mkdir(directory))
+    return false;
+
+  // segment numbers increase, the queue is the range between the lowest and highest
+  bool found = false;
+  uint32_t lowest = 0;
+  uint32_t highest = 0;
+  Dir dir = LittleFS.openDir(directory);
+  while (dir.next())
+  {
+    String name = dir.fileName();
+    char *end;
+    uint32_t segment = strtoul(name.c_str(), &end, 10);
+    if (strcmp(end, ".seg") != 0)
+      continue;
+    if (!found || segment < lowest)
+      lowest = segment;
+    if (!found || segment >= highest)
+    {
+      highest = segment;
+      lastSegmentSize = dir.fileSize();
+    }
+    found = true;
+  }
+
+  firstSegment = found ? lowest : 0;
+  nextSegment = found ? highest + 1 : 0;
+  return true;
+}
+
+bool LogSpillQueue::spill(const LogRecordBuffer &buffer, size_t start)
+{
+  File file;
+  bool ok = true;
+  size_t offset = 0;
+  buffer.forEach([&](uint8_t level, const uint8_t *data, size_t length) {
+    size_t recordStart = offset;
+    size_t recordSize = LogRecordBuffer::HEADER_SIZE + length;
+    offset += recordSize;
+    if (recordStart < start || !ok)
+      return;
+
+    if (isEmpty() || lastSegmentSize + recordSize > segmentSize)
+    {
+      // start a new segment, making room by dropping the oldest
+      if (file)
+        file.close();
+      if (segmentCount() >= maxSegments)
+        evictOldest();
+      nextSegment++;
+      lastSegmentSize = 0;
+    }
+    if (!file)
+    {
+      file = LittleFS.open(segmentPath(nextSegment - 1), "a");
+      if (!file)
+      {
+        ok = false;
+        return;
+      }
+    }
+
+    uint8_t header[LogRecordBuffer::HEADER_SIZE] = {level, (uint8_t)length, (uint8_t)(length >> 8)};
+    if (file.write(header, sizeof(header)) != sizeof(header) || file.write(data, length) != length)
+    {
+      ok = false;
+      return;
+    }
+    lastSegmentSize += recordSize;
+    spilledBytes += length;
+  });
+
+  if (file)
+    file.close();
+  return ok;
+}
+
+bool LogSpillQueue::load(LogRecordBuffer &buffer)
+{
+  while (!isEmpty())
+  {
+    File file = LittleFS.open(segmentPath(firstSegment), "r");
+    if (!file)
+    {
+      firstSegment++; // lost, e.g. power loss while deleting
+      continue;
+    }
+
+    loadedBytes = 0;
+    uint8_t header[LogRecordBuffer::HEADER_SIZE];
+    while (file.read(header, sizeof(header)) == sizeof(header))
+    {
+      size_t length = header[1] | (header[2] << 8);
+      uint8_t *payload = buffer.append(header[0], length);
+      if (payload == nullptr)
+        break; // damaged
+      if (file.read(payload, length) != length)
+      {
+        // cut off by a reset while appending
+        buffer.truncate(buffer.size() - LogRecordBuffer::HEADER_SIZE - length);
+        break;
+      }
+      loadedBytes += length;
+    }
+    file.close();
+
+    loaded = true;
+    loadedSegment = firstSegment;
+    if (firstSegment == nextSegment - 1)
+      lastSegmentSize = segmentSize; // never append to a segment in flight
+
+    if (buffer.isEmpty())
+    {
+      removeOldest();
+      continue;
+    }
+    return true;
+  }
+  return false;
+}
+
+void LogSpillQueue::removeOldest()
+{
+  replayedBytes += loadedBytes;
+  loadedBytes = 0;
+  // it may have been evicted while it was sent
+  if (loaded && loadedSegment == firstSegment && !isEmpty())
+  {
+    LittleFS.remove(segmentPath(firstSegment));
+    firstSegment++;
+  }
+  loaded = false;
+}
+
+void LogSpillQueue::evictOldest()
+{
+  String path = segmentPath(firstSegment);
+  File file = LittleFS.open(path, "r");
+  if (file)
+  {
+    evictedBytes += file.size();
+    file.close();
+  }
+  LittleFS.remove(path);
+  if (loaded && loadedSegment == firstSegment)
+    loaded = false;
+  firstSegment++;
+}
@@ -0,0 +1,58 @@
+#ifndef LOGSPILLQUEUE_H
+#define LOGSPILLQUEUE_H
+
+#include <Arduino.h>
+
+#include "LogRecordBuffer.h"
+
+// Append-only queue of log records in segment files on LittleFS, for log
+// lines that do not fit into RAM while the log server is unreachable.
+// Segments are numbered files in the queue directory holding records in the
+// LogRecordBuffer layout. A segment is written once by appending and deleted
+// as a whole after it was sent (or evicted as the oldest when the queue is
+// full), so flash blocks are never rewritten in place. The queue survives
+// resets and deep sleep.
+class LogSpillQueue
+{
+public:
+  LogSpillQueue(const char *directory = "/logq", size_t segmentSize = 1024, uint16_t maxSegments = 32);
+
+  // Finds the segments left from before the reset. Requires LittleFS to be mounted.
+  bool begin();
+
+  bool isEmpty() const { return firstSegment == nextSegment; }
+  uint16_t segmentCount() const { return nextSegment - firstSegment; }
+
+  // Appends the records of buffer from offset start on. Returns false on a file system error.
+  bool spill(const LogRecordBuffer &buffer, size_t start);
+
+  // Loads the records of the oldest segment into buffer (which must be empty
+  // and at least segmentSize large). Returns false if there is none or it is damaged.
+  bool load(LogRecordBuffer &buffer);
+  // Deletes the oldest segment after it was sent
+  void removeOldest();
+
+  // Counters since boot
+  uint32_t getSpilledBytes() const { return spilledBytes; }
+  uint32_t getReplayedBytes() const { return replayedBytes; }
+  uint32_t getEvictedBytes() const { return evictedBytes; }
+
+private:
+  String directory;
+  size_t segmentSize;
+  uint16_t maxSegments;
+  uint32_t firstSegment = 0; // oldest segment
+  uint32_t nextSegment = 0;  // number of the segment after the newest
+  size_t lastSegmentSize = 0;
+  bool loaded = false;       // a segment was loaded and is being sent
+  uint32_t loadedSegment = 0;
+  size_t loadedBytes = 0;
+  uint32_t spilledBytes = 0;
+  uint32_t replayedBytes = 0;
+  uint32_t evictedBytes = 0;
+
+  String segmentPath(uint32_t segment) const;
+  void evictOldest();
+};
+
+#endif // LOGSPILLQUEUE_H
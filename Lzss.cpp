@@ -0,0 +1,96 @@
+#include "Lzss.h"
+#include <new>
+
+size_t Lzss::compress(const uint8_t *in, size_t size, uint8_t *out, size_t capacity)
+{
+  if (size == 0 || size >= 0xFFFF)
+    return 0;
+
+  // hash chains over the last WINDOW_SIZE positions: position + 1, 0 = none.
+  // Older links are never followed, so their slots are reused.
+  uint16_t head[HASH_SIZE] = {};
+  size_t chainSize = chainEntries(size);
+  size_t chainMask = chainSize == WINDOW_SIZE ? WINDOW_SIZE - 1 : SIZE_MAX;
+  uint16_t *prev = new (std::nothrow) uint16_t[chainSize];
+  if (prev == nullptr)
+    return 0;
+
+  auto insert = [&](size_t position) {
+    if (position + MIN_MATCH <= size)
+    {
+      uint8_t h = hash(in + position);
+      prev[position & chainMask] = head[h];
+      head[h] = position + 1;
+    }
+  };
+
+  size_t written = 0;
+  size_t flagPosition = 0;
+  uint8_t flagBit = 8;
+  size_t position = 0;
+  while (position < size)
+  {
+    if (flagBit == 8)
+    {
+      if (written >= capacity)
+        break;
+      flagPosition = written++;
+      out[flagPosition] = 0;
+      flagBit = 0;
+    }
+
+    // longest match among the most recent candidates with the same hash
+    size_t bestLength = 0;
+    size_t bestDistance = 0;
+    if (position + MIN_MATCH <= size)
+    {
+      size_t maxLength = size - position < MAX_MATCH ? size - position : MAX_MATCH;
+      uint16_t candidate = head[hash(in + position)];
+      for (uint8_t probe = 0; candidate != 0 && probe < MAX_PROBES; probe++)
+      {
+        size_t start = candidate - 1;
+        size_t distance = position - start;
+        // checked before following the link: the slot of start is reused
+        // once position passes start + WINDOW_SIZE
+        if (distance > WINDOW_SIZE)
+          break;
+        size_t length = 0;
+        while (length < maxLength && in[start + length] == in[position + length])
+          length++;
+        if (length > bestLength)
+        {
+          bestLength = length;
+          bestDistance = distance;
+          if (length == maxLength)
+            break;
+        }
+        candidate = prev[start & chainMask];
+      }
+    }
+
+    if (bestLength >= MIN_MATCH)
+    {
+      if (written + 2 > capacity)
+        break;
+      uint16_t token = ((bestDistance - 1) << 4) | (bestLength - MIN_MATCH);
+      out[written++] = (uint8_t)token;
+      out[written++] = (uint8_t)(token >> 8);
+      for (size_t i = 0; i < bestLength; i++)
+        insert(position + i);
+      position += bestLength;
+    }
+    else
+    {
+      if (written >= capacity)
+        break;
+      out[flagPosition] |= 1 << flagBit;
+      out[written++] = in[position];
+      insert(position);
+      position++;
+    }
+    flagBit++;
+  }
+
+  delete[] prev;
+  return position < size ? 0 : written;
+}
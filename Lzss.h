@@ -0,0 +1,35 @@
+#ifndef LZSS_H
+#define LZSS_H
+
+#include <Arduino.h>
+
+// Small LZSS compressor for log batches, sent with "Content-Encoding: x-lzss".
+// Format: groups of a flag byte and 8 items, flag bits LSB first.
+// Bit set: literal byte. Bit clear: back reference of 2 bytes, little endian,
+// ((distance - 1) << 4) | (length - 3), distance 1..4096, length 3..18.
+// The data ends with the last item, unused flag bits are ignored.
+// The decoder is lzss_decompress() in ESP8266_server_app.py.
+class Lzss
+{
+public:
+  static const size_t WINDOW_SIZE = 4096;
+  static const size_t MIN_MATCH = 3;
+  static const size_t MAX_MATCH = 18;
+
+  // Compresses in (up to 64 KB) to out. Returns the compressed size, or 0 if it
+  // does not fit into capacity (e.g. incompressible data) or memory is short.
+  // Besides 512 bytes of stack it allocates chainBytes(size) on the heap.
+  static size_t compress(const uint8_t *in, size_t size, uint8_t *out, size_t capacity);
+
+  // Heap used by the match finder: hash chains over the window, not the input
+  static size_t chainBytes(size_t size) { return chainEntries(size) * sizeof(uint16_t); }
+
+private:
+  static const size_t HASH_SIZE = 256; // 512 bytes of stack for the hash heads
+  static const uint8_t MAX_PROBES = 16; // candidates checked per position
+
+  static size_t chainEntries(size_t size) { return size < WINDOW_SIZE ? size : WINDOW_SIZE; }
+  static uint8_t hash(const uint8_t *p) { return (uint8_t)((p[0] * 33 + p[1]) * 33 + p[2]); }
+};
+
+#endif // LZSS_H
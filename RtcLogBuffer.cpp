@@ -0,0 +1,65 @@
+#include "RtcLogBuffer.h"
+#include <coredecls.h>
+
+RtcLogBuffer::RtcLogBuffer(uint32_t offset, size_t size)
+  : LogRecordBuffer((size - sizeof(Header)) & ~(size_t)3), offset(offset)
+{
+}
+
+uint32_t RtcLogBuffer::crc(const Header &header) const
+{
+  uint32_t value = crc32(&header.used, sizeof(header.used));
+  value = crc32(&header.tag, sizeof(header.tag), value);
+  return crc32(buffer, used, value);
+}
+
+bool RtcLogBuffer::load()
+{
+  clear();
+
+  Header header;
+  if (!ESP.rtcUserMemoryRead(offset, reinterpret_cast<uint32_t *>(&header), sizeof(header)))
+    return false;
+  if (header.magic != MAGIC || header.used > capacity)
+    return false;
+
+  // the data size is rounded up to whole RTC blocks
+  size_t size = (header.used + 3) & ~(size_t)3;
+  if (!ESP.rtcUserMemoryRead(offset + sizeof(header) / 4, reinterpret_cast<uint32_t *>(buffer), size))
+    return false;
+
+  used = header.used;
+  if (crc(header) != header.crc)
+  {
+    clear();
+    return false;
+  }
+
+  // rebuild the record index, the layout must add up exactly
+  size_t next = 0;
+  while (next + HEADER_SIZE <= used)
+  {
+    lastRecord = next;
+    records++;
+    next += HEADER_SIZE + recordLength(next);
+  }
+  if (next != used)
+  {
+    clear();
+    return false;
+  }
+
+  tag = header.tag;
+  return records > 0;
+}
+
+bool RtcLogBuffer::save()
+{
+  Header header = {MAGIC, (uint16_t)used, tag, 0, 0};
+  header.crc = crc(header);
+
+  size_t size = (used + 3) & ~(size_t)3;
+  if (size > 0 && !ESP.rtcUserMemoryWrite(offset + sizeof(header) / 4, reinterpret_cast<uint32_t *>(buffer), size))
+    return false;
+  return ESP.rtcUserMemoryWrite(offset, reinterpret_cast<uint32_t *>(&header), sizeof(header));
+}
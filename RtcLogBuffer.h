@@ -0,0 +1,45 @@
+#ifndef RTCLOGBUFFER_H
+#define RTCLOGBUFFER_H
+
+#include <Arduino.h>
+
+#include "LogRecordBuffer.h"
+
+// Log record buffer mirrored to RTC user memory, protected by a CRC.
+// RTC memory survives deep sleep, watchdog and soft resets, so log lines that
+// could not be sent before the reset can be shipped after the next wake.
+// Uses its own range of RTC user memory: keep clear of the RTCVars storage.
+class RtcLogBuffer : public LogRecordBuffer
+{
+public:
+  // offset in 4 byte blocks of RTC user memory, size in bytes including the header
+  RtcLogBuffer(uint32_t offset, size_t size);
+
+  // Restores the records saved before the reset. Returns false if there are none or they are corrupt.
+  bool load();
+  // Writes the records to RTC memory
+  bool save();
+
+  // Application defined tag saved with the records, e.g. the content format
+  uint8_t getTag() const { return tag; }
+  void setTag(uint8_t value) { tag = value; }
+
+private:
+  struct Header
+  {
+    uint32_t magic;
+    uint16_t used;
+    uint8_t tag;
+    uint8_t reserved;
+    uint32_t crc;
+  };
+
+  static const uint32_t MAGIC = 0x4C4F4754; // "LOGT"
+
+  uint32_t offset;
+  uint8_t tag = 0;
+
+  uint32_t crc(const Header &header) const;
+};
+
+#endif // RTCLOGBUFFER_H
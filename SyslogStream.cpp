@@ -0,0 +1,153 @@
+#include "SyslogStream.h"
+#include <time.h>
+
+SyslogStream::SyslogStream(const char *host, uint16_t port, const char *hostname, const char *appName, bool batch)
+  : host(host), port(port), hostname(hostname), appName(appName), batch(batch)
+{
+  // header fields must not be empty or contain spaces
+  if (this->hostname.isEmpty()) {
+    this->hostname = "-";
+  }
+  if (this->appName.isEmpty()) {
+    this->appName = "-";
+  }
+}
+
+size_t SyslogStream::write(uint8_t val)
+{
+  return writeLeveled(DEFAULT_LEVEL, &val, 1);
+}
+
+size_t SyslogStream::write(const uint8_t *buf, size_t size)
+{
+  return writeLeveled(DEFAULT_LEVEL, buf, size);
+}
+
+size_t SyslogStream::writeLeveled(uint8_t level, const uint8_t *buf, size_t size)
+{
+  for (size_t i = 0; i < size; i++)
+  {
+    if (lineLength == 0) {
+      lineLevel = level; // a line keeps the level it was started with
+    }
+    if (buf[i] == '\n') {
+      addMessage(lineLevel, line, lineLength);
+      lineLength = 0;
+    }
+    else if (buf[i] != '\r') {
+      line[lineLength++] = buf[i];
+      if (lineLength == sizeof(line)) {
+        addMessage(lineLevel, line, lineLength); // overlong lines are split
+        lineLength = 0;
+      }
+    }
+  }
+  return size;
+}
+
+void SyslogStream::flush()
+{
+  sendDatagram();
+}
+
+void SyslogStream::begin()
+{
+  resolve();
+}
+
+void SyslogStream::poll()
+{
+  if (!resolved && (resolveRetryDelay == 0 || (unsigned long)(millis() - lastResolve) >= resolveRetryDelay)) {
+    resolve();
+  }
+  if (datagramLength > 0 && (unsigned long)(millis() - datagramSince) >= maxDelayMillis) {
+    sendDatagram();
+  }
+}
+
+// Blocking DNS lookup, so only called from begin() and poll()
+void SyslogStream::resolve()
+{
+  lastResolve = millis();
+  resolved = WiFi.hostByName(host.c_str(), address, RESOLVE_TIMEOUT_MILLIS) == 1;
+  if (resolved) {
+    resolveRetryDelay = 0;
+  }
+  else {
+    resolveRetryDelay = resolveRetryDelay == 0 ? RESOLVE_RETRY_MIN_MILLIS : resolveRetryDelay * 2;
+    if (resolveRetryDelay > RESOLVE_RETRY_MAX_MILLIS) {
+      resolveRetryDelay = RESOLVE_RETRY_MAX_MILLIS;
+    }
+  }
+}
+
+void SyslogStream::addMessage(uint8_t level, const char *text, size_t length)
+{
+  char timestamp[24] = "-";
+  time_t now = time(nullptr);
+  if (now > 1000000000) { // only once NTP time is set
+    struct tm tm;
+    gmtime_r(&now, &tm);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", &tm);
+  }
+
+  char header[96];
+  int headerLength = snprintf(header, sizeof(header), "<%u>1 %s %s %s - - - ",
+    FACILITY * 8 + severity(level), timestamp, hostname.c_str(), appName.c_str());
+  if (headerLength < 0) {
+    return;
+  }
+  if ((size_t)headerLength >= sizeof(header)) {
+    headerLength = sizeof(header) - 1;
+  }
+
+  // batched messages are separated by a newline
+  size_t separator = datagramLength > 0 ? 1 : 0;
+  if (datagramLength + separator + headerLength + length > sizeof(datagram)) {
+    sendDatagram();
+    separator = 0;
+  }
+  if (headerLength + length > sizeof(datagram)) {
+    length = sizeof(datagram) - headerLength;
+  }
+
+  if (datagramLength == 0) {
+    datagramSince = millis();
+  }
+  if (separator) {
+    datagram[datagramLength++] = '\n';
+  }
+  memcpy(datagram + datagramLength, header, headerLength);
+  datagramLength += headerLength;
+  memcpy(datagram + datagramLength, text, length);
+  datagramLength += length;
+  datagramMessages++;
+
+  if (!batch) {
+    sendDatagram();
+  }
+}
+
+void SyslogStream::sendDatagram()
+{
+  if (datagramLength == 0) {
+    return;
+  }
+
+  // no DNS lookup here: this runs inside console.log()
+  if (!resolved || !udp.beginPacket(address, port) || udp.write((const uint8_t *)datagram, datagramLength) != datagramLength || !udp.endPacket()) {
+    droppedMessages += datagramMessages;
+  }
+  datagramLength = 0;
+  datagramMessages = 0;
+}
+
+// Syslog severity of a Console log level
+uint8_t SyslogStream::severity(uint8_t level)
+{
+  if (level >= 50) return 2; // CRITICAL -> critical
+  if (level >= 40) return 3; // ERROR -> error
+  if (level >= 30) return 4; // WARNING -> warning
+  if (level >= 20) return 6; // INFO -> informational
+  return 7;                  // DEBUG -> debug
+}
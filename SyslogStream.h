@@ -0,0 +1,90 @@
+#ifndef SYSLOGSTREAM_H
+#define SYSLOGSTREAM_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <WiFiUdp.h>
+
+#include "LeveledOutput.h"
+
+#define SYSLOG_LINE_SIZE 256
+#define SYSLOG_DATAGRAM_SIZE 1024
+
+// Fire-and-forget log sink sending each log line as RFC 5424 syslog message over UDP:
+//   <PRI>1 TIMESTAMP HOSTNAME APP-NAME - - - MSG
+// The header carries time and severity, so the sink is added with
+// Console::SINK_NO_PREFIX and MSG is the bare message.
+// With batching several messages, separated by newlines, share one datagram. This
+// is not standard (RFC 5426 has one message per datagram): only the log server app
+// splits them, other receivers take the datagram as one message.
+// The datagram is sent when the next message does not fit, after maxDelayMillis
+// (see poll()) or on flush(). Without batching every message is sent right away
+// as one datagram, as RFC 5426 expects. Nothing is retransmitted: messages are
+// lost while WiFi is down or when the receiver is not listening.
+// The host is resolved by begin() and poll() only, never on the write path: until
+// the lookup succeeded datagrams are counted as dropped.
+class SyslogStream : public Stream, public LeveledOutput
+{
+protected:
+  WiFiUDP udp;
+  String host;
+  IPAddress address; // resolved once by begin() or poll()
+  bool resolved = false;
+  uint16_t port;
+  String hostname;
+  String appName;
+  bool batch;
+  uint32_t maxDelayMillis = 1000;
+
+  // line being written, a message is complete at its newline
+  char line[SYSLOG_LINE_SIZE];
+  size_t lineLength = 0;
+  uint8_t lineLevel = DEFAULT_LEVEL;
+
+  char datagram[SYSLOG_DATAGRAM_SIZE];
+  size_t datagramLength = 0;
+  uint16_t datagramMessages = 0;
+  uint32_t datagramSince = 0; // millis() of the first message in the datagram
+  uint32_t droppedMessages = 0;
+
+  static const uint8_t FACILITY = 16; // local0
+
+  static const uint32_t RESOLVE_TIMEOUT_MILLIS = 2000;
+  static const uint32_t RESOLVE_RETRY_MIN_MILLIS = 1000;
+  static const uint32_t RESOLVE_RETRY_MAX_MILLIS = 60000;
+  uint32_t resolveRetryDelay = 0; // 0 = no failed lookup
+  uint32_t lastResolve = 0;
+
+public:
+  SyslogStream(const char *host, uint16_t port, const char *hostname, const char *appName, bool batch = true);
+
+  size_t write(uint8_t val) override;
+  size_t write(const uint8_t *buf, size_t size) override;
+  size_t writeLeveled(uint8_t level, const uint8_t *buf, size_t size) override;
+
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  // Sends the pending datagram
+  void flush() override;
+
+  void setMaxDelay(uint32_t millis) { maxDelayMillis = millis; }
+
+  // Resolves the host, call once WiFi is connected
+  void begin();
+
+  // Resolves the host with backoff while it failed and sends a batched
+  // datagram older than maxDelayMillis, call from loop()
+  void poll();
+
+  // Messages lost because a datagram could not be sent
+  uint32_t getDroppedMessages() const { return droppedMessages; }
+
+private:
+  void resolve();
+  void addMessage(uint8_t level, const char *text, size_t length);
+  void sendDatagram();
+  static uint8_t severity(uint8_t level);
+};
+
+#endif // SYSLOGSTREAM_H
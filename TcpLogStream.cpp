@@ -0,0 +1,162 @@
+#include "TcpLogStream.h"
+#include "Console.h"
+#include <base64.h>
+
+TcpLogStream::TcpLogStream(const char *host, uint16_t port, const char *logId, const char *username, const char *password, bool debug)
+  : host(host), port(port), logId(logId), records(TCP_LOG_BUFFER_SIZE), debug(debug)
+{
+  if (username != nullptr && strlen(username) > 0) {
+    auth = base64::encode(String(username) + ":" + password, false);
+  }
+  else {
+    auth = "-";
+  }
+}
+
+size_t TcpLogStream::write(uint8_t val)
+{
+  return writeLeveled(DEFAULT_LEVEL, &val, 1);
+}
+
+size_t TcpLogStream::write(const uint8_t *buf, size_t size)
+{
+  return writeLeveled(DEFAULT_LEVEL, buf, size);
+}
+
+size_t TcpLogStream::writeLeveled(uint8_t level, const uint8_t *buf, size_t size)
+{
+  if (size == 0) {
+    return 0;
+  }
+
+  // everything goes through the buffer: what the connection does not take now is sent by poll()
+  bool merge = !binary && lineOpen;
+  size_t written = records.write(level, buf, size, merge);
+  if (!binary && written > 0) {
+    lineOpen = buf[size - 1] != '\n';
+  }
+
+  if (!suspended && client.connected()) {
+    sendBufferedData();
+  }
+  return written;
+}
+
+void TcpLogStream::flush()
+{
+  if (suspended) {
+    return;
+  }
+  poll();
+
+  uint32_t start = millis();
+  while (!records.isEmpty() && client.connected() && (unsigned long)(millis() - start) < FLUSH_TIMEOUT_MILLIS) {
+    sendBufferedData();
+    delay(1);
+  }
+  client.flush();
+}
+
+void TcpLogStream::poll()
+{
+  if (suspended) {
+    return;
+  }
+
+  if (!client.connected()) {
+    if (retryDelay > 0 && (unsigned long)(millis() - lastAttempt) < retryDelay) {
+      return;
+    }
+    lastAttempt = millis();
+    if (!connect()) {
+      retryDelay = retryDelay == 0 ? RETRY_DELAY_MIN_MILLIS : retryDelay * 2;
+      if (retryDelay > RETRY_DELAY_MAX_MILLIS) {
+        retryDelay = RETRY_DELAY_MAX_MILLIS;
+      }
+      if (debug) {
+        Serial.printf("[TcpLogStream] Cannot connect to %s:%d, retry in %d ms\n", host.c_str(), port, retryDelay);
+      }
+      return;
+    }
+    retryDelay = 0;
+  }
+
+  // the server never sends anything but may close the connection
+  while (client.available() > 0) {
+    client.read();
+  }
+  sendBufferedData();
+}
+
+bool TcpLogStream::connect()
+{
+  client.stop();
+  client.setTimeout(CONNECT_TIMEOUT_MILLIS);
+  if (!client.connect(host.c_str(), port)) {
+    return false;
+  }
+  // records are small and should arrive as they are written
+  client.setNoDelay(true);
+
+  String hello = String("LOG1 ") + (binary ? "binary " : "text ") + auth + " " + logId + "\n";
+  if (client.write((const uint8_t *)hello.c_str(), hello.length()) != hello.length()) {
+    client.stop();
+    return false;
+  }
+  lineOpen = false; // a line cut off by the lost connection is not continued
+  if (debug) {
+    Serial.printf("[TcpLogStream] Connected to %s:%d\n", host.c_str(), port);
+  }
+  return true;
+}
+
+// Writes as much buffered data as the connection takes without blocking
+void TcpLogStream::sendBufferedData()
+{
+  uint8_t chunk[TCP_LOG_CHUNK_SIZE];
+
+  uint32_t dropped[LogRecordBuffer::LEVEL_COUNT];
+  if (records.hasDropped() && (size_t)client.availableForWrite() >= sizeof(chunk)) {
+    records.takeDropped(dropped);
+    size_t offset = binary ? Console::RECORD_TEXT_HEADER_SIZE : 0;
+    int length = snprintf((char *)chunk + offset, sizeof(chunk) - offset,
+      "[TcpLogStream] dropped records DEBUG=%u INFO=%u WARNING=%u ERROR=%u CRITICAL=%u\n",
+      dropped[0], dropped[1], dropped[2], dropped[3], dropped[4]);
+    if (binary) {
+      chunk[0] = Console::RECORD_TEXT;
+      chunk[1] = (uint8_t)length;
+      chunk[2] = (uint8_t)(length >> 8);
+    }
+    client.write(chunk, offset + length);
+  }
+
+  while (!records.isEmpty()) {
+    size_t room = client.availableForWrite();
+    if (room == 0) {
+      break;
+    }
+    if (binary) {
+      // whole records only: after a reconnect the server could not find the start
+      // of the next record behind the rest of a partially sent one
+      const uint8_t *data;
+      size_t length = records.span(LogRecordBuffer::Cursor(), data);
+      if (room < length) {
+        break;
+      }
+      size_t sent = client.write(data, length);
+      records.read(nullptr, length);
+      if (sent < length) {
+        // broken connection: the rest of the record is lost with it
+        client.stop();
+        break;
+      }
+      continue;
+    }
+    size_t length = records.read(chunk, room < sizeof(chunk) ? room : sizeof(chunk));
+    if (client.write(chunk, length) < length) {
+      // broken connection: reconnect from poll()
+      client.stop();
+      break;
+    }
+  }
+}
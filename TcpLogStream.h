@@ -0,0 +1,71 @@
+#ifndef TCPLOGSTREAM_H
+#define TCPLOGSTREAM_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+
+#include "LeveledOutput.h"
+#include "LogRecordBuffer.h"
+
+#define TCP_LOG_BUFFER_SIZE 1024
+#define TCP_LOG_CHUNK_SIZE 256
+
+// Log sink keeping one TCP connection to the log server app open for the
+// whole awake period and writing log data as it is produced, instead of one
+// HTTP request per batch. The connection starts with a hello line
+//   LOG1 <text|binary> <base64 user:password or -> <log id>\n
+// followed by the plain log text or binary log records (see Console::RECORD_LOG).
+// Data written while disconnected or faster than the connection accepts it is
+// kept in a LogRecordBuffer, DEBUG/INFO being evicted first. Binary records are
+// only sent whole, so the stream after a new hello line starts at a record.
+// There are no acknowledgements: data in flight when the connection breaks is lost.
+class TcpLogStream : public Stream, public LeveledOutput
+{
+protected:
+  WiFiClient client;
+  String host;
+  uint16_t port;
+  String logId;
+  String auth;
+  LogRecordBuffer records;
+  bool lineOpen = false; // last text write did not end with a newline
+  bool binary = false;
+  bool suspended = false;
+  bool debug;
+
+  static const uint32_t CONNECT_TIMEOUT_MILLIS = 2000;
+  static const uint32_t FLUSH_TIMEOUT_MILLIS = 1000;
+  static const uint32_t RETRY_DELAY_MIN_MILLIS = 1000;
+  static const uint32_t RETRY_DELAY_MAX_MILLIS = 60000;
+  uint32_t retryDelay = 0; // 0 = no failed attempt
+  uint32_t lastAttempt = 0;
+
+public:
+  TcpLogStream(const char *host, uint16_t port, const char *logId, const char *username, const char *password, bool debug = false);
+
+  size_t write(uint8_t val) override;
+  size_t write(const uint8_t *buf, size_t size) override;
+  size_t writeLeveled(uint8_t level, const uint8_t *buf, size_t size) override;
+
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  // Waits up to FLUSH_TIMEOUT_MILLIS for the buffered data to be sent
+  void flush() override;
+
+  // Binary log records instead of text, must be set before the first connection
+  void setBinary(bool enable) { binary = enable; }
+
+  // While suspended nothing is sent, e.g. before deep sleep
+  void setSuspended(bool enable) { suspended = enable; }
+
+  // (Re)connects with exponential backoff and sends buffered data, call from loop()
+  void poll();
+  bool connected() { return client.connected(); }
+
+private:
+  bool connect();
+  void sendBufferedData();
+};
+
+#endif // TCPLOGSTREAM_H
@@ -1,64 +1,264 @@
 #include "TelnetStreamBuffered.h"
 
-TelnetStreamBuffered::TelnetStreamBuffered(uint16_t port) : TelnetStreamClass(port), overwriting(false) {}
+TelnetStreamBuffered::TelnetStreamBuffered(uint16_t port, size_t bufferSize) : server(port)
+{
+  // positions are mapped to the ring with a mask, so they may wrap around
+  ringSize = 64;
+  while (ringSize * 2 <= bufferSize)
+    ringSize *= 2;
+  ring = new uint8_t[ringSize];
+}
+
+TelnetStreamBuffered::~TelnetStreamBuffered()
+{
+  for (uint8_t i = 0; i < TELNET_MAX_CLIENTS; i++)
+    clients[i].stop();
+  delete[] ring;
+}
+
+void TelnetStreamBuffered::begin(uint16_t port)
+{
+  server.begin(port);
+}
 
 size_t TelnetStreamBuffered::write(uint8_t val)
 {
-  if (disconnected())
+  return writeLeveled(DEFAULT_LEVEL, &val, 1);
+}
+
+size_t TelnetStreamBuffered::write(const uint8_t *buf, size_t size)
+{
+  return writeLeveled(DEFAULT_LEVEL, buf, size);
+}
+
+size_t TelnetStreamBuffered::writeLeveled(uint8_t level, const uint8_t *buf, size_t size)
+{
+  if (size == 0)
+    return 0;
+
+  // the level of a line is decided at its first piece, so a line is kept or dropped as a whole
+  if (!lineOpen)
   {
-    if (!buffer.push(val) && !overwriting)
+    char marker[64];
+    int markerLength = 0;
+    if (dropped[0] > 0 || dropped[1] > 0)
+      markerLength = snprintf(marker, sizeof(marker), "[telnet: %u DEBUG, %u INFO lines dropped]\r\n",
+                              (unsigned)dropped[0], (unsigned)dropped[1]);
+
+    droppingLine = level < TELNET_PROTECTED_LEVEL && overwritesProtected(markerLength + size);
+    if (droppingLine)
     {
-      overwriting = true;
-      Serial.println("TelnetStreamBuffered: buffer is full; now overwriting old data");
+      dropped[LogRecordBuffer::levelIndex(level)]++;
     }
+    else
+    {
+      if (markerLength > 0)
+      {
+        protectLine(head); // kept like the lines it stands for are not
+        append((const uint8_t *)marker, markerLength);
+        memset(dropped, 0, sizeof(dropped));
+      }
+      if (level >= TELNET_PROTECTED_LEVEL)
+        protectLine(head);
+    }
+  }
+  lineOpen = buf[size - 1] != '\n';
 
-    return 1; // we still have stored data
+  if (!droppingLine)
+    append(buf, size);
+  for (uint8_t i = 0; i < TELNET_MAX_CLIENTS; i++)
+    if (clients[i])
+      sendToClient(i);
+  return size;
+}
+
+void TelnetStreamBuffered::append(const uint8_t *buf, size_t size)
+{
+  // only the newest ringSize bytes of a long write can be kept
+  const uint8_t *data = buf;
+  size_t length = size;
+  if (length > ringSize)
+  {
+    data += length - ringSize;
+    head += length - ringSize;
+    length = ringSize;
   }
-  else
+
+  size_t offset = head & (ringSize - 1);
+  size_t first = ringSize - offset < length ? ringSize - offset : length;
+  memcpy(ring + offset, data, first);
+  memcpy(ring, data + first, length - first);
+  head += length;
+  stored = stored + length < ringSize ? stored + length : ringSize;
+
+  // forget the protected lines that were overwritten
+  while (protectedCount > 0 && (int32_t)(head - stored - protectedLines[protectedFirst]) > 0)
   {
-    flushBufferedData();
-    return TelnetStreamClass::write(val);
+    protectedFirst = (protectedFirst + 1) % TELNET_PROTECTED_LINES;
+    protectedCount--;
   }
 }
 
-size_t TelnetStreamBuffered::write(const uint8_t *buf, size_t size)
+// True if writing size bytes would overwrite a protected line that a client has not
+// sent yet, or that is kept for the next client while none is connected
+bool TelnetStreamBuffered::overwritesProtected(size_t size)
 {
-  if (disconnected())
-  {
-    bool isFull = false;
-    for (size_t i = 0; i < size; i++)
-      isFull = !buffer.push(buf[i]);
-    if (isFull && !overwriting)
-    {
-      overwriting = true;
-      Serial.println("TelnetStreamBuffered: buffer is full; now overwriting old data");
-    }
+  if (stored + size <= ringSize)
+    return false;
+  uint32_t oldest = head + size - ringSize; // oldest byte left after the write
+
+  bool connected = false;
+  for (uint8_t i = 0; i < TELNET_MAX_CLIENTS; i++)
+    connected = connected || clients[i];
 
-    return size; // we still have stored data
+  for (uint8_t n = 0; n < protectedCount; n++)
+  {
+    uint32_t line = protectedLines[(protectedFirst + n) % TELNET_PROTECTED_LINES];
+    if ((int32_t)(oldest - line) <= 0)
+      return false; // this and the newer protected lines survive the write
+    if (!connected)
+      return true;
+    for (uint8_t i = 0; i < TELNET_MAX_CLIENTS; i++)
+      if (clients[i] && (int32_t)(line - cursors[i]) >= 0)
+        return true;
   }
-  else
+  return false;
+}
+
+void TelnetStreamBuffered::protectLine(uint32_t position)
+{
+  if (protectedCount == TELNET_PROTECTED_LINES)
   {
-    flushBufferedData();
-    return TelnetStreamClass::write(buf, size);
+    // the oldest one loses its protection
+    protectedFirst = (protectedFirst + 1) % TELNET_PROTECTED_LINES;
+    protectedCount--;
   }
+  protectedLines[(protectedFirst + protectedCount) % TELNET_PROTECTED_LINES] = position;
+  protectedCount++;
+}
+
+int TelnetStreamBuffered::available()
+{
+  int index = inputClient();
+  return index < 0 ? 0 : clients[index].available();
+}
+
+int TelnetStreamBuffered::read()
+{
+  int index = inputClient();
+  return index < 0 ? -1 : clients[index].read();
+}
+
+int TelnetStreamBuffered::peek()
+{
+  int index = inputClient();
+  return index < 0 ? -1 : clients[index].peek();
 }
 
 void TelnetStreamBuffered::flush()
 {
-  if (!disconnected())
+  poll();
+}
+
+void TelnetStreamBuffered::poll()
+{
+  acceptClients();
+  for (uint8_t i = 0; i < TELNET_MAX_CLIENTS; i++)
   {
-    flushBufferedData();
-    TelnetStreamClass::flush();
+    if (!clients[i])
+      continue;
+    if (!clients[i].connected())
+    {
+      clients[i].stop(); // frees the slot
+      continue;
+    }
+    sendToClient(i);
   }
 }
 
-void TelnetStreamBuffered::flushBufferedData()
+uint8_t TelnetStreamBuffered::clientCount()
 {
-  int flushed = 0;
-  while (!buffer.isEmpty())
-    flushed += TelnetStreamClass::write(buffer.shift());
-  if (flushed > 0)
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < TELNET_MAX_CLIENTS; i++)
+    if (clients[i].connected())
+      count++;
+  return count;
+}
+
+void TelnetStreamBuffered::acceptClients()
+{
+  while (server.hasClient())
   {
-    overwriting = false;
+    WiFiClient client = server.accept();
+    uint8_t i = 0;
+    while (i < TELNET_MAX_CLIENTS && clients[i].connected())
+      i++;
+    if (i == TELNET_MAX_CLIENTS)
+    {
+      client.print("Too many telnet clients\r\n");
+      client.stop();
+      continue;
+    }
+    clients[i].stop();
+    clients[i] = client;
+    cursors[i] = oldestLine();
+    sendToClient(i);
   }
-}
\ No newline at end of file
+}
+
+// Writes what the send window of the client takes, never waits
+void TelnetStreamBuffered::sendToClient(uint8_t index)
+{
+  WiFiClient &client = clients[index];
+  uint32_t &cursor = cursors[index];
+
+  if (head - cursor > stored)
+  {
+    // overwritten before this client took it: continue at a line start
+    char marker[48];
+    uint32_t next = oldestLine();
+    int length = snprintf(marker, sizeof(marker), "\r\n[telnet: %u bytes skipped]\r\n", next - cursor);
+    if ((size_t)client.availableForWrite() < (size_t)length)
+      return; // retried on the next write or poll()
+    client.write((const uint8_t *)marker, length);
+    cursor = next;
+  }
+
+  while (cursor != head)
+  {
+    size_t room = client.availableForWrite();
+    if (room == 0)
+      break;
+    size_t offset = cursor & (ringSize - 1);
+    size_t length = head - cursor;
+    if (length > ringSize - offset)
+      length = ringSize - offset; // up to the end of the ring, the rest in the next round
+    if (length > room)
+      length = room;
+    size_t written = client.write(ring + offset, length);
+    cursor += written;
+    if (written < length)
+      break;
+  }
+}
+
+// Position of the first complete line still in the ring
+uint32_t TelnetStreamBuffered::oldestLine()
+{
+  uint32_t position = head - stored;
+  if (stored < ringSize)
+    return position; // nothing overwritten yet
+  for (uint32_t scan = position; scan != head; scan++)
+    if (ring[scan & (ringSize - 1)] == '\n')
+      return scan + 1;
+  return position; // no line end: start with what is there
+}
+
+// First client with input, -1 if none
+int TelnetStreamBuffered::inputClient()
+{
+  for (uint8_t i = 0; i < TELNET_MAX_CLIENTS; i++)
+    if (clients[i] && clients[i].available() > 0)
+      return i;
+  return -1;
+}
@@ -2,25 +2,73 @@
 #define TELNETSTREAMBUFFERED_H
 
 #include <Arduino.h>
-#include <TelnetStream.h>
-#include <CircularBuffer.hpp>
+#include <ESP8266WiFi.h>
 
-class TelnetStreamBuffered : public TelnetStreamClass
+#include "LeveledOutput.h"
+#include "LogRecordBuffer.h"
+
+#define TELNET_BUFFER_SIZE 1024
+#define TELNET_MAX_CLIENTS 4
+#define TELNET_PROTECTED_LINES 8   // WARNING and above lines tracked in the ring
+#define TELNET_PROTECTED_LEVEL 30  // Console::WARNING
+
+// Telnet console for several clients at once. Output goes to a shared byte ring
+// (the newest bufferSize bytes, rounded down to a power of two) and every client
+// reads it at its own cursor, with as much as its send window takes. Writers never
+// wait for a client: a client falling behind by more than the ring is skipped
+// forward to the oldest complete line, with a gap marker. A new client first gets
+// the lines still in the ring, e.g. the log of the wake before it connected.
+// A DEBUG/INFO line that would overwrite a WARNING or higher line not yet sent to
+// every client (or kept for the next one) is dropped instead and counted by level.
+// Input is read from the clients in turn.
+class TelnetStreamBuffered : public Stream, public LeveledOutput
 {
 protected:
-  CircularBuffer<uint8_t, 512> buffer;
+  WiFiServer server;
+  WiFiClient clients[TELNET_MAX_CLIENTS];
+  uint32_t cursors[TELNET_MAX_CLIENTS]; // ring position each client has sent up to
+
+  uint8_t *ring;
+  size_t ringSize; // power of two
+  size_t stored = 0; // bytes in the ring, at most ringSize
+  uint32_t head = 0; // bytes written since start, position of the next byte
 
-  boolean overwriting;
+  // start positions of the WARNING and above lines still in the ring, oldest first
+  uint32_t protectedLines[TELNET_PROTECTED_LINES];
+  uint8_t protectedFirst = 0;
+  uint8_t protectedCount = 0;
+
+  bool lineOpen = false;     // last write did not end with a newline
+  bool droppingLine = false; // the rest of the open line is dropped too
+  uint32_t dropped[LogRecordBuffer::LEVEL_COUNT] = {};
 
 public:
-  TelnetStreamBuffered(uint16_t port);
+  TelnetStreamBuffered(uint16_t port, size_t bufferSize = TELNET_BUFFER_SIZE);
+  ~TelnetStreamBuffered();
+
+  void begin(uint16_t port);
+
+  size_t write(uint8_t val) override;
+  size_t write(const uint8_t *buf, size_t size) override;
+  size_t writeLeveled(uint8_t level, const uint8_t *buf, size_t size) override;
+  int available() override;
+  int read() override;
+  int peek() override;
+  // Sends what the clients take without waiting
+  void flush() override;
 
-  size_t write(uint8_t val);
-  size_t write(const uint8_t *buf, size_t size);
-  void flush();
+  // Accepts new clients and sends them the rest of the ring, call from loop()
+  void poll();
+  uint8_t clientCount();
 
 private:
-  void flushBufferedData();
+  void acceptClients();
+  void append(const uint8_t *buf, size_t size);
+  bool overwritesProtected(size_t size);
+  void protectLine(uint32_t position);
+  void sendToClient(uint8_t index);
+  uint32_t oldestLine();
+  int inputClient();
 };
 
 #endif // TELNETSTREAMBUFFERED_H
@@ -16,8 +16,13 @@
 // use either CONSOLE_TELNET or CONSOLE_HTTP
 // #define CONSOLE_TELNET                // console output can be accessed by telnet server on ESP
 #define CONSOLE_HTTP               // console output sent to a HTTP server app to view
+#define RTC_LOG_TAIL                  // keep unsent HTTP log lines in RTC memory over deep sleep and resets
+#define HTTP_LOG_SPILL                // queue HTTP log lines on LittleFS while the log server is unreachable
+// #define CONSOLE_TCP                   // console output streamed over one persistent TCP connection to the log server app
+// #define CONSOLE_SYSLOG                // console output sent as UDP syslog messages (RFC 5424), not acknowledged
 #define USE_NTP                       // connect to NTP server to retrieve time
 #define USE_MDNS                      // allow hostnet resolution via mDNS in local networks
+// #define LOG_MIN_LEVEL 20              // remove CONSOLE_LOG calls below this level at compile time (10=DEBUG ... 50=CRITICAL)
 
 // important for reliable deep sleep wake up and reset via UART for flashing
 // use a BAT43 Schottky Diode: RST (Anode +) ---D|--- (Cathode -) D0
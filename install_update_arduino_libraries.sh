@@ -16,8 +16,6 @@ repos=(
     "https://github.com/bblanchon/ArduinoJson.git"
     "https://github.com/tzapu/WiFiManager.git"
     "https://github.com/highno/rtcvars.git"
-    "https://github.com/rlogiacco/CircularBuffer.git"
-    "https://github.com/JAndrassy/TelnetStream.git"
 )
 
 # Loop through each repository
@@ -0,0 +1,110 @@
+// Cycles per log line of Console::log with two sinks: the current single buffer
+// formatter (one write() per sink) against the formatter it replaced, which
+// printed timestamp, level and message with six print() calls going byte by byte
+// through Console::write(uint8_t) into both streams.
+#include "Console.h"
+#include "null_stream.h"
+
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint64_t cycleCount() { return __rdtsc(); }
+#else
+static inline uint64_t cycleCount() { return 0; } // only ns are reported
+#endif
+
+// Console::log and Console::write(uint8_t) before the single buffer formatter
+class LegacyConsole : public Stream
+{
+public:
+  LegacyConsole(Stream &primary, Stream &secondary) : primaryStream(&primary), secondaryOutputStream(&secondary) {}
+
+  size_t write(uint8_t data) override
+  {
+    if (secondaryOutputStream != nullptr)
+      secondaryOutputStream->write(data);
+    return primaryStream->write(data);
+  }
+  using Print::write;
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+
+  void log(Console::LogLevel level, const __FlashStringHelper *format, ...)
+  {
+    const char *fmt = reinterpret_cast<const char *>(format);
+
+    time_t localTime = time(nullptr);
+    struct tm *tm = localtime(&localTime);
+
+    char temp[100];
+    strftime(temp, sizeof(temp), timeFormat, tm);
+    print(temp);
+    print(" ");
+
+    print(Console::getLogLevelString(level));
+    print(" ");
+
+    va_list arg;
+    va_start(arg, format);
+    vsnprintf(temp, sizeof(temp), fmt, arg);
+    va_end(arg);
+    print(temp);
+    print("\n");
+  }
+
+private:
+  Stream *primaryStream;
+  Stream *secondaryOutputStream;
+  char timeFormat[32] = "%Y-%m-%d %H:%M:%S";
+};
+
+static const int LINES = 200000;
+static const char *LONG_TEXT = "GET /event/next?client_id=esp8266-zoomrec-livingroom&lead_time_sec=60&trail_time_sec=60 "
+                               "returned 200 with dtstart_instance_lead, dtend_instance_trail and dtnow";
+
+struct Result
+{
+  double cycles;
+  double nanos;
+  size_t bytes;
+};
+
+template <typename Log>
+static Result measure(Log log, NullStream &sink)
+{
+  sink.bytes = 0;
+  auto start = std::chrono::steady_clock::now();
+  uint64_t startCycles = cycleCount();
+  for (int i = 0; i < LINES; i++)
+    log(i);
+  uint64_t cycles = cycleCount() - startCycles;
+  double nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  return {(double)cycles / LINES, nanos / LINES, sink.bytes / LINES};
+}
+
+static void print(const char *name, const Result &result)
+{
+  printf("%-22s %8.0f %8.0f %8zu\n", name, result.cycles, result.nanos, result.bytes);
+}
+
+int main()
+{
+  NullStream first, second;
+  LegacyConsole legacy(first, second);
+
+  Console console;
+  console.removeSink(Serial);
+  console.addSink(first);
+  console.addSink(second);
+  console.setLogLevel(Console::DEBUG);
+  console.setDeduplicate(false);
+
+  printf("per line (2 sinks)     %8s %8s %8s\n", "cycles", "ns", "bytes");
+  print("short, before", measure([&](int i) { legacy.log(Console::INFO, F("Free heap: %d Max Free Block: %d"), 30000 + i, 20000 + i); }, first));
+  print("short, single buffer", measure([&](int i) { console.log(Console::INFO, F("Free heap: %d Max Free Block: %d"), 30000 + i, 20000 + i); }, first));
+  // the old formatter truncates the message to 99 bytes
+  print("long, before", measure([&](int i) { legacy.log(Console::INFO, F("%d %s"), i, LONG_TEXT); }, first));
+  print("long, single buffer", measure([&](int i) { console.log(Console::INFO, F("%d %s"), i, LONG_TEXT); }, first));
+  return 0;
+}
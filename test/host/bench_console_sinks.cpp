@@ -0,0 +1,50 @@
+// Latency of one Console::log line with one, two and three sinks attached, and
+// with a third, non-blocking sink that is stalled (availableForWrite() == 0)
+#include "Console.h"
+#include "null_stream.h"
+
+#include <chrono>
+
+static const int LINES = 200000;
+
+static double nanosPerLine(Console &console)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < LINES; i++)
+    console.log(Console::INFO, F("Free heap: %d Max Free Block: %d"), 30000 + i, 20000 + i);
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / LINES;
+}
+
+int main()
+{
+  NullStream sinks[3];
+  NullStream stalled;
+
+  printf("%-36s %8s\n", "sinks", "ns/line");
+  for (int count = 1; count <= 3; count++)
+  {
+    Console console;
+    console.removeSink(Serial);
+    console.setDeduplicate(false);
+    for (int i = 0; i < count; i++)
+      console.addSink(sinks[i]);
+    char name[40];
+    snprintf(name, sizeof(name), "%d blocking", count);
+    printf("%-36s %8.0f\n", name, nanosPerLine(console));
+  }
+
+  Console console;
+  console.removeSink(Serial);
+  console.setDeduplicate(false);
+  console.addSink(sinks[0]);
+  console.addSink(sinks[1]);
+  console.addSink(stalled, Console::DEBUG, Console::SINK_NONBLOCKING);
+  // the sink had room once, so it is not taken for a stream without availableForWrite()
+  stalled.space = 4096;
+  console.log(Console::INFO, F("connected"));
+  stalled.space = 0;
+  double nanos = nanosPerLine(console);
+  printf("%-36s %8.0f   (%u bytes dropped)\n", "2 blocking + 1 stalled non-blocking", nanos,
+         console.getSinkDroppedBytes(stalled));
+  return 0;
+}
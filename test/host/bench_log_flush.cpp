@@ -0,0 +1,270 @@
+// Throughput of an HTTP log flush against a local stand-in log server: one POST
+// per flush with the body streamed from the record buffer by LogBodyStream,
+// against the previous flush sending a JSON envelope with the url-encoded
+// content for every 256 byte piece of the buffer. These requests use a new
+// connection each, as HTTPClient did without keep-alive; the last case sends the
+// streamed POSTs over one kept connection, as the JSONAPIClient pool does.
+// Loopback has no round trip time, so the server can delay each response, and a
+// new connection waits the same time once more for the TCP handshake:
+//   bench_log_flush [round trip ms]
+#include "LogBodyStream.h"
+#include "LogRecordBuffer.h"
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+static const size_t BUFFER_SIZE = 1024;
+static const size_t FLUSH_BUFFER_SIZE = 256;
+static int rounds = 2000;
+static int responseDelayMillis = 0;
+static const char *PREFIX = "{\"id\":\"ESP8266_zoomrec.ino\",\"content\":\"";
+static const char *SUFFIX = "\"}";
+
+// Answers each request with 200. The connection is closed after a request with
+// "Connection: close", otherwise it is kept for the next request.
+static void serve(int listener)
+{
+  for (;;)
+  {
+    int connection = accept(listener, nullptr, nullptr);
+    if (connection < 0)
+      return;
+    std::string request;
+    char buffer[4096];
+    bool keepAlive = true;
+    while (keepAlive)
+    {
+      size_t bodyStart = std::string::npos;
+      size_t contentLength = 0;
+      ssize_t length = 0;
+      while (bodyStart == std::string::npos || request.size() < bodyStart + contentLength)
+      {
+        if (bodyStart == std::string::npos && (bodyStart = request.find("\r\n\r\n")) != std::string::npos)
+        {
+          bodyStart += 4;
+          size_t header = request.find("Content-Length: ");
+          contentLength = header != std::string::npos ? strtoul(request.c_str() + header + 16, nullptr, 10) : 0;
+          continue;
+        }
+        if ((length = recv(connection, buffer, sizeof(buffer), 0)) <= 0)
+          break;
+        request.append(buffer, length);
+      }
+      if (length < 0 || bodyStart == std::string::npos || request.size() < bodyStart + contentLength)
+        break;
+      keepAlive = request.substr(0, bodyStart).find("Connection: close") == std::string::npos;
+      request.erase(0, bodyStart + contentLength);
+      if (responseDelayMillis > 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(responseDelayMillis));
+      const char *response = keepAlive
+        ? "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 2\r\nConnection: keep-alive\r\n\r\n{}"
+        : "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 2\r\nConnection: close\r\n\r\n{}";
+      send(connection, response, strlen(response), MSG_NOSIGNAL);
+    }
+    close(connection);
+  }
+}
+
+static int connectTo(uint16_t port)
+{
+  // the SYN/SYN-ACK round trip of a new connection
+  if (responseDelayMillis > 0)
+    std::this_thread::sleep_for(std::chrono::milliseconds(responseDelayMillis));
+
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(fd, (sockaddr *)&address, sizeof(address)) != 0)
+  {
+    perror("connect");
+    exit(1);
+  }
+  // no Nagle/delayed ACK stalls between the header and the body writes
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  return fd;
+}
+
+static void sendHeader(int fd, size_t contentLength, bool keepAlive)
+{
+  char header[256];
+  int length = snprintf(header, sizeof(header),
+                        "POST /log HTTP/1.1\r\nHost: 127.0.0.1\r\nUser-Agent: ESP8266HTTPClient\r\n"
+                        "Connection: %s\r\nContent-Type: application/json\r\nContent-Length: %zu\r\n\r\n",
+                        keepAlive ? "keep-alive" : "close", contentLength);
+  send(fd, header, length, MSG_NOSIGNAL);
+}
+
+static void awaitResponse(int fd)
+{
+  char buffer[512];
+  while (recv(fd, buffer, sizeof(buffer), 0) > 0)
+    ;
+  close(fd);
+}
+
+// The response on a kept connection ends with its 2 byte body
+static void awaitKeptResponse(int fd)
+{
+  std::string response;
+  char buffer[512];
+  ssize_t length;
+  while ((response.size() < 6 || response.compare(response.size() - 6, 6, "\r\n\r\n{}") != 0) &&
+         (length = recv(fd, buffer, sizeof(buffer), 0)) > 0)
+    response.append(buffer, length);
+}
+
+// Same encoding as the UrlEncode library
+static std::string urlEncode(const char *data, size_t length)
+{
+  static const char HEX_DIGITS[] = "0123456789ABCDEF";
+  std::string encoded;
+  encoded.reserve(length * 3);
+  for (size_t i = 0; i < length; i++)
+  {
+    uint8_t c = data[i];
+    if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~')
+      encoded += (char)c;
+    else
+    {
+      encoded += '%';
+      encoded += HEX_DIGITS[c >> 4];
+      encoded += HEX_DIGITS[c & 0x0F];
+    }
+  }
+  return encoded;
+}
+
+struct Result
+{
+  double seconds = 0;
+  size_t logBytes = 0;
+  size_t bodyBytes = 0;
+  size_t requests = 0;
+};
+
+static void fill(LogRecordBuffer &records, std::string &plain)
+{
+  records.clear();
+  plain.clear();
+  for (unsigned i = 0;; i++)
+  {
+    char line[128];
+    int length = snprintf(line, sizeof(line), "2025-01-01 12:00:%02u INFO Free heap: %u Max Free Block: %u%.*s\n",
+                          i % 60, 30000 + i * 17, 20000 + i * 13, (int)(i % 8) * 8, "................................................................");
+    if (records.available() < LogRecordBuffer::HEADER_SIZE + length)
+      return;
+    records.write(20, (const uint8_t *)line, length);
+    plain.append(line, length);
+  }
+}
+
+static Result benchChunked(uint16_t port)
+{
+  LogRecordBuffer records(BUFFER_SIZE);
+  std::string plain;
+  Result result;
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++)
+  {
+    fill(records, plain);
+    for (size_t offset = 0; offset < plain.size(); offset += FLUSH_BUFFER_SIZE)
+    {
+      size_t length = std::min(FLUSH_BUFFER_SIZE, plain.size() - offset);
+      std::string body = std::string(PREFIX) + urlEncode(plain.data() + offset, length) + SUFFIX;
+      int fd = connectTo(port);
+      sendHeader(fd, body.size(), false);
+      send(fd, body.data(), body.size(), MSG_NOSIGNAL);
+      awaitResponse(fd);
+      result.bodyBytes += body.size();
+      result.requests++;
+    }
+    result.logBytes += plain.size();
+  }
+  result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return result;
+}
+
+static Result benchStreamed(uint16_t port, bool keepAlive)
+{
+  LogRecordBuffer records(BUFFER_SIZE);
+  std::string plain;
+  Result result;
+  int fd = -1;
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++)
+  {
+    fill(records, plain);
+    records.mark();
+    LogBodyStream body(records, records.markedSize(), PREFIX, SUFFIX, "", 0, LogBodyStream::ENCODING_URL);
+    if (fd < 0)
+      fd = connectTo(port);
+    sendHeader(fd, body.size(), keepAlive);
+    // as HTTPClient pulls a peek buffer stream: each piece is written in place
+    while (body.peekAvailable() > 0)
+    {
+      size_t length = body.peekAvailable();
+      send(fd, body.peekBuffer(), length, MSG_NOSIGNAL);
+      body.peekConsume(length);
+    }
+    if (keepAlive)
+      awaitKeptResponse(fd);
+    else
+    {
+      awaitResponse(fd);
+      fd = -1;
+    }
+    result.bodyBytes += body.size();
+    result.requests++;
+    result.logBytes += plain.size();
+  }
+  result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  if (fd >= 0)
+    close(fd);
+  return result;
+}
+
+static void print(const char *name, const Result &result)
+{
+  printf("%-30s %10.0f %12.2f %12.0f\n", name, result.logBytes / result.seconds,
+         result.requests * 1024.0 / result.logBytes, (double)result.bodyBytes / result.requests);
+}
+
+int main(int argc, char **argv)
+{
+  if (argc > 1)
+  {
+    responseDelayMillis = atoi(argv[1]);
+    rounds = 100;
+  }
+
+  int listener = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t addressLength = sizeof(address);
+  if (bind(listener, (sockaddr *)&address, sizeof(address)) != 0 || listen(listener, 16) != 0 ||
+      getsockname(listener, (sockaddr *)&address, &addressLength) != 0)
+  {
+    perror("listen");
+    return 1;
+  }
+  std::thread server(serve, listener);
+  server.detach();
+  uint16_t port = ntohs(address.sin_port);
+
+  printf("round trip %d ms, %d flushes\n", responseDelayMillis, rounds);
+  printf("%-30s %10s %12s %12s\n", "flush of a 1 KB buffer", "log B/s", "requests/KB", "body B/req");
+  print("256 byte pieces, JSON each", benchChunked(port));
+  print("one streamed POST", benchStreamed(port, false));
+  print("one streamed POST, kept", benchStreamed(port, true));
+  return 0;
+}
@@ -0,0 +1,174 @@
+// Bytes/us of the HTTP log buffer: LogRecordBuffer (memcpy writes, drained
+// through span()) against the per-byte CircularBuffer push()/shift() path
+// HttpStreamBuffered used before. Each round fills a 1 KB buffer with log lines
+// and drains it in 256 byte pieces, as a flush does.
+#include "LogRecordBuffer.h"
+
+#include <chrono>
+#include <stdio.h>
+
+// push()/shift() of CircularBuffer 1.3 (rlogiacco), the library previously used
+template <typename T, size_t S>
+class CircularBuffer
+{
+public:
+  bool push(T value)
+  {
+    if (++tail == buffer + S)
+      tail = buffer;
+    *tail = value;
+    if (count == S)
+    {
+      if (++head == buffer + S)
+        head = buffer;
+      return false;
+    }
+    if (count++ == 0)
+      head = tail;
+    return true;
+  }
+
+  T shift()
+  {
+    if (count == 0)
+      return *head;
+    T result = *head++;
+    if (head >= buffer + S)
+      head = buffer;
+    count--;
+    return result;
+  }
+
+  size_t available() const { return S - count; }
+  bool isEmpty() const { return count == 0; }
+
+private:
+  T buffer[S];
+  T *head = buffer;
+  T *tail = buffer;
+  size_t count = 0;
+};
+
+static const size_t BUFFER_SIZE = 1024;
+static const size_t FLUSH_SIZE = 256;
+static const int ROUNDS = 200000;
+
+static char lines[8][128];
+static size_t lineLengths[8];
+
+using Clock = std::chrono::steady_clock;
+
+static double microsSince(Clock::time_point start)
+{
+  return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+struct Result
+{
+  double writeMicros = 0;
+  double drainMicros = 0;
+  size_t bytes = 0;
+  uint32_t checksum = 0;
+};
+
+static Result benchCircularBuffer()
+{
+  static CircularBuffer<uint8_t, BUFFER_SIZE> buffer;
+  uint8_t flushBuffer[FLUSH_SIZE];
+  Result result;
+  for (int round = 0; round < ROUNDS; round++)
+  {
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0;; i++)
+    {
+      const char *line = lines[i % 8];
+      size_t length = lineLengths[i % 8];
+      if (buffer.available() < length)
+        break;
+      for (size_t j = 0; j < length; j++)
+        buffer.push(line[j]);
+      result.bytes += length;
+    }
+    result.writeMicros += microsSince(start);
+
+    start = Clock::now();
+    while (!buffer.isEmpty())
+    {
+      size_t length = 0;
+      while (length < FLUSH_SIZE && !buffer.isEmpty())
+        flushBuffer[length++] = buffer.shift();
+      result.checksum += flushBuffer[length - 1] + length;
+    }
+    result.drainMicros += microsSince(start);
+  }
+  return result;
+}
+
+static Result benchLogRecordBuffer()
+{
+  LogRecordBuffer records(BUFFER_SIZE);
+  uint8_t socketBuffer[FLUSH_SIZE];
+  Result result;
+  for (int round = 0; round < ROUNDS; round++)
+  {
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0;; i++)
+    {
+      size_t length = lineLengths[i % 8];
+      if (records.available() < LogRecordBuffer::HEADER_SIZE + length)
+        break;
+      records.write(20, (const uint8_t *)lines[i % 8], length);
+      result.bytes += length;
+    }
+    result.writeMicros += microsSince(start);
+
+    // the spans are handed to the socket, which copies them
+    start = Clock::now();
+    records.mark();
+    LogRecordBuffer::Cursor cursor;
+    size_t queued = 0;
+    const uint8_t *data;
+    size_t length;
+    while ((length = records.span(cursor, data, records.markedSize())) > 0)
+    {
+      if (length > FLUSH_SIZE - queued)
+        length = FLUSH_SIZE - queued;
+      memcpy(socketBuffer + queued, data, length);
+      queued += length;
+      records.skip(cursor, length);
+      if (queued == FLUSH_SIZE)
+      {
+        result.checksum += socketBuffer[queued - 1] + queued;
+        queued = 0;
+      }
+    }
+    if (queued > 0)
+      result.checksum += socketBuffer[queued - 1] + queued;
+    records.removeMarked();
+    result.drainMicros += microsSince(start);
+  }
+  return result;
+}
+
+static void print(const char *name, const Result &result)
+{
+  printf("%-16s %10.1f %10.1f %10.1f   (checksum %u)\n", name,
+         result.bytes / result.writeMicros,
+         result.bytes / result.drainMicros,
+         result.bytes / (result.writeMicros + result.drainMicros),
+         result.checksum);
+}
+
+int main()
+{
+  for (size_t i = 0; i < 8; i++)
+    lineLengths[i] = snprintf(lines[i], sizeof(lines[i]),
+                              "2025-01-01 12:00:%02u INFO Free heap: %u Max Free Block: %u%.*s\n",
+                              (unsigned)i, 30000 + (unsigned)i * 17, 20000 + (unsigned)i * 13,
+                              (int)(i * 8), "........................................................................");
+
+  printf("bytes/us         %10s %10s %10s\n", "write", "drain", "total");
+  print("CircularBuffer", benchCircularBuffer());
+  print("LogRecordBuffer", benchLogRecordBuffer());
+  return 0;
+}
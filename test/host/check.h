@@ -0,0 +1,21 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+// assert() replacement that also works in Release builds and keeps going
+static int checkFailures = 0;
+
+#define CHECK(condition)                                                            \
+  do                                                                                \
+  {                                                                                 \
+    if (!(condition))                                                               \
+    {                                                                               \
+      fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+      checkFailures++;                                                              \
+    }                                                                               \
+  } while (0)
+
+#define CHECK_RESULT() (checkFailures == 0 ? 0 : 1)
+
+#endif // CHECK_H
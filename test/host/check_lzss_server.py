@@ -0,0 +1,39 @@
+"""Decodes the output of "test_lzss --dump" with lzss_decompress() of the log server.
+
+Usage: check_lzss_server.py ESP8266_server_app.py path/to/test_lzss
+Only the decoder function is taken from the server, Flask is not needed.
+"""
+import ast
+import subprocess
+import sys
+
+
+def load_decoder(path):
+    with open(path) as source:
+        tree = ast.parse(source.read(), path)
+    decoder = [node for node in tree.body
+               if isinstance(node, ast.FunctionDef) and node.name == 'lzss_decompress']
+    namespace = {}
+    exec(compile(ast.Module(body=decoder, type_ignores=[]), path, 'exec'), namespace)
+    return namespace['lzss_decompress']
+
+
+def unhex(text):
+    return b'' if text == '-' else bytes.fromhex(text)
+
+
+def main():
+    lzss_decompress = load_decoder(sys.argv[1])
+    dump = subprocess.run([sys.argv[2], '--dump'], check=True, capture_output=True, text=True).stdout
+    failures = 0
+    for number, line in enumerate(dump.splitlines()):
+        plain, packed = (unhex(part) for part in line.split())
+        if lzss_decompress(packed) != (plain if packed else b''):
+            print('case %d: decoded data differs from the input' % number)
+            failures += 1
+    print('%d cases, %d failed' % (len(dump.splitlines()), failures))
+    return 1 if failures else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
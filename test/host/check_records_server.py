@@ -0,0 +1,92 @@
+"""Expands the output of "test_console_records --dump" with the log server's decoders.
+
+Usage: check_records_server.py ESP8266_server_app.py path/to/test_console_records
+format_record() must give what printf gave on the host for every record, and
+decode_binary_log() must take the whole stream. Only the decoder functions and
+constants are taken from the server, Flask is not needed; the format strings
+come from the dump instead of the firmware ELF.
+"""
+import ast
+import re
+import struct
+import subprocess
+import sys
+from datetime import datetime
+
+NAMES = {'RECORD_LOG', 'RECORD_TEXT', 'RECORD_LOG_HEADER', 'RECORD_TEXT_HEADER', 'LOG_LEVELS', 'FORMAT_SPEC',
+         'format_record', 'decode_binary_log'}
+
+
+def load_decoders(path):
+    with open(path) as source:
+        tree = ast.parse(source.read(), path)
+    nodes = []
+    for node in tree.body:
+        if isinstance(node, ast.FunctionDef) and node.name in NAMES:
+            nodes.append(node)
+        elif isinstance(node, ast.Assign) and any(isinstance(t, ast.Name) and t.id in NAMES for t in node.targets):
+            nodes.append(node)
+    namespace = {'re': re, 'struct': struct, 'datetime': datetime}
+    exec(compile(ast.Module(body=nodes, type_ignores=[]), path, 'exec'), namespace)
+    return namespace
+
+
+def unhex(text):
+    return b'' if text == '-' else bytes.fromhex(text)
+
+
+def main():
+    server = load_decoders(sys.argv[1])
+    dump = subprocess.run([sys.argv[2], '--dump'], check=True, capture_output=True, text=True).stdout
+    formats = {}
+    expected = []
+    text = ''
+    stream = b''
+    for line in dump.splitlines():
+        kind, *fields = line.split()
+        if kind == 'format':
+            fmt = unhex(fields[1]).decode()
+            formats[int(fields[0], 16)] = fmt
+            expected.append((fmt, unhex(fields[2]).decode()))
+        elif kind == 'text':
+            text = unhex(fields[0]).decode()
+        elif kind == 'stream':
+            stream = unhex(fields[0])
+
+    failures = 0
+    # format_record() per RECORD_LOG
+    pos = 0
+    records = 0
+    header = server['RECORD_LOG_HEADER']
+    while pos < len(stream) and stream[pos] == server['RECORD_LOG']:
+        _, _, _, address, arg_length = header.unpack_from(stream, pos)
+        args = stream[pos + header.size:pos + header.size + arg_length]
+        fmt, printed = expected[records]
+        decoded = server['format_record'](formats[address], args)
+        if decoded != printed:
+            print('format_record("%s"): %r, printf: %r' % (fmt, decoded, printed))
+            failures += 1
+        pos += header.size + arg_length
+        records += 1
+    if records != len(expected):
+        print('%d log records in the stream, %d expected' % (records, len(expected)))
+        failures += 1
+
+    # the whole stream, text records included
+    server['lookup_format'] = formats.get
+    decoded, remaining = server['decode_binary_log'](stream)
+    lines = decoded.splitlines(keepends=True)
+    messages = [line.split(' ', 3)[3].rstrip('\n') for line in lines[:len(expected)]]
+    if messages != [printed for _, printed in expected] or any(' INFO ' not in line for line in lines[:len(expected)]):
+        print('decode_binary_log() log lines differ')
+        failures += 1
+    if ''.join(lines[len(expected):]) != text or remaining:
+        print('decode_binary_log() text records differ or bytes remain')
+        failures += 1
+
+    print('%d records, %d failed' % (records, failures))
+    return 1 if failures else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
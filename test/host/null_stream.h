@@ -0,0 +1,23 @@
+#ifndef NULL_STREAM_H
+#define NULL_STREAM_H
+
+#include <Arduino.h>
+
+// Sink that only counts bytes, like a sink copying them into its buffer.
+// With space set, availableForWrite() reports it, e.g. 0 for a stalled network sink.
+class NullStream : public Stream
+{
+public:
+  size_t bytes = 0;
+  int space = 4096;
+
+  size_t write(uint8_t) override { bytes++; return 1; }
+  size_t write(const uint8_t *, size_t size) override { bytes += size; return size; }
+  using Print::write;
+  int availableForWrite() override { return space; }
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+};
+
+#endif // NULL_STREAM_H
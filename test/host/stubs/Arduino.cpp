@@ -0,0 +1,46 @@
+#include <Arduino.h>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+static unsigned long simulatedMillis = 0;
+
+unsigned long millis() { return simulatedMillis; }
+unsigned long micros() { return simulatedMillis * 1000; }
+void delay(unsigned long ms) { simulatedMillis += ms; }
+void advanceMillis(unsigned long ms) { simulatedMillis += ms; }
+
+char *ultoa(unsigned long value, char *buffer, int base)
+{
+  snprintf(buffer, 24, base == 16 ? "%lx" : "%lu", value);
+  return buffer;
+}
+
+size_t Print::printf(const char *format, ...)
+{
+  char buffer[256];
+  va_list arg;
+  va_start(arg, format);
+  int length = vsnprintf(buffer, sizeof(buffer), format, arg);
+  va_end(arg);
+  if (length < 0)
+    return 0;
+  return write((const uint8_t *)buffer, (size_t)length < sizeof(buffer) ? length : sizeof(buffer) - 1);
+}
+
+bool EspClass::rtcUserMemoryRead(uint32_t offset, uint32_t *data, size_t size)
+{
+  if (offset * 4 + size > RTC_USER_MEMORY_SIZE)
+    return false;
+  memcpy(data, rtcUserMemory + offset * 4, size);
+  return true;
+}
+
+bool EspClass::rtcUserMemoryWrite(uint32_t offset, uint32_t *data, size_t size)
+{
+  if (offset * 4 + size > RTC_USER_MEMORY_SIZE)
+    return false;
+  memcpy(rtcUserMemory + offset * 4, data, size);
+  rtcWrites++;
+  return true;
+}
@@ -0,0 +1,176 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+// Minimal host stand-in for the ESP8266 Arduino core: just enough to build the
+// log classes and the sinks using them for the tests and benchmarks in test/host.
+// Not a general purpose emulation.
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/types.h>
+#include <time.h>
+
+#include <string>
+
+#define IRAM_ATTR
+#define PROGMEM
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+#define PSTR(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+
+inline size_t strlen_P(const char *s) { return strlen(s); }
+inline size_t strnlen_P(const char *s, size_t n) { return strnlen(s, n); }
+inline void *memcpy_P(void *dest, const void *src, size_t n) { return memcpy(dest, src, n); }
+
+// Simulated clock, only advanced by delay() and advanceMillis()
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void advanceMillis(unsigned long ms);
+inline void yield() {}
+
+char *ultoa(unsigned long value, char *buffer, int base);
+
+// The subset of the Arduino String used by the sketch classes built here
+class String
+{
+public:
+  String(const char *s = "") : text(s != nullptr ? s : "") {}
+  String(const std::string &s) : text(s) {}
+  explicit String(char c) : text(1, c) {}
+  explicit String(int value) : text(std::to_string(value)) {}
+  explicit String(unsigned int value) : text(std::to_string(value)) {}
+  explicit String(long value) : text(std::to_string(value)) {}
+  explicit String(unsigned long value) : text(std::to_string(value)) {}
+
+  const char *c_str() const { return text.c_str(); }
+  unsigned int length() const { return text.size(); }
+  bool reserve(unsigned int size) { text.reserve(size); return true; }
+  char operator[](unsigned int index) const { return index < text.size() ? text[index] : 0; }
+
+  String &operator+=(const String &s) { text += s.text; return *this; }
+  String &operator+=(const char *s) { text += s; return *this; }
+  String &operator+=(char c) { text += c; return *this; }
+  friend String operator+(const String &a, const String &b) { return String(a.text + b.text); }
+  friend String operator+(const String &a, const char *b) { return String(a.text + b); }
+  friend String operator+(const char *a, const String &b) { return String(a + b.text); }
+  bool operator==(const String &s) const { return text == s.text; }
+  bool operator==(const char *s) const { return text == s; }
+  bool operator!=(const String &s) const { return text != s.text; }
+
+  int indexOf(char c, unsigned int from = 0) const { return find(text.find(c, from)); }
+  int indexOf(const char *s, unsigned int from = 0) const { return find(text.find(s, from)); }
+  String substring(unsigned int from, unsigned int to) const { return from < text.size() ? String(text.substr(from, to - from)) : String(); }
+  String substring(unsigned int from) const { return from < text.size() ? String(text.substr(from)) : String(); }
+  void remove(unsigned int index) { if (index < text.size()) text.erase(index); }
+  void remove(unsigned int index, unsigned int count) { if (index < text.size()) text.erase(index, count); }
+  bool equalsIgnoreCase(const String &s) const { return strcasecmp(text.c_str(), s.text.c_str()) == 0; }
+  bool startsWith(const char *s) const { return text.compare(0, strlen(s), s) == 0; }
+
+private:
+  std::string text;
+
+  static int find(size_t position) { return position == std::string::npos ? -1 : (int)position; }
+};
+
+class Print
+{
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size)
+  {
+    size_t n = 0;
+    while (size--)
+      n += write(*buffer++);
+    return n;
+  }
+  size_t write(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+  virtual int availableForWrite() { return 0; }
+  virtual void flush() {}
+
+  size_t print(const char *s) { return write(s); }
+  size_t print(const String &s) { return write(s.c_str()); }
+  size_t println(const String &s) { return print(s) + println(); }
+  size_t print(const __FlashStringHelper *s) { return print(reinterpret_cast<const char *>(s)); }
+  size_t println(const char *s) { return print(s) + println(); }
+  size_t println() { return print("\r\n"); }
+  size_t printf(const char *format, ...);
+};
+
+class Stream : public Print
+{
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  virtual int read(uint8_t *buffer, size_t size)
+  {
+    size_t n = 0;
+    int c;
+    while (n < size && (c = read()) >= 0)
+      buffer[n++] = (uint8_t)c;
+    return n;
+  }
+
+  // Peek buffer API of the ESP8266 core 3.x
+  virtual bool hasPeekBufferAPI() const { return false; }
+  virtual size_t peekAvailable() { return 0; }
+  virtual const char *peekBuffer() { return nullptr; }
+  virtual void peekConsume(size_t) {}
+  virtual bool inputCanTimeout() { return true; }
+  virtual ssize_t streamRemaining() { return -1; }
+};
+
+// Serial output is discarded and only counted, flush() calls included
+class HardwareSerial : public Stream
+{
+public:
+  size_t written = 0;
+  size_t flushes = 0;
+
+  void begin(unsigned long) {}
+  size_t write(uint8_t) override { written++; return 1; }
+  size_t write(const uint8_t *, size_t size) override { written += size; return size; }
+  using Print::write;
+  int availableForWrite() override { return 128; }
+  void flush() override { flushes++; }
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+};
+
+extern HardwareSerial Serial;
+
+// Heap figures are set by the tests, RTC user memory keeps its content across
+// objects like the real one keeps it across resets
+class EspClass
+{
+public:
+  static const size_t RTC_USER_MEMORY_SIZE = 512;
+
+  uint32_t freeHeap = 40000;
+  uint32_t maxFreeBlockSize = 30000;
+  uint32_t rtcWrites = 0; // rtcUserMemoryWrite() calls
+
+  uint32_t random() { return (uint32_t)rand(); }
+  uint32_t getFreeHeap() { return freeHeap; }
+  uint32_t getMaxFreeBlockSize() { return maxFreeBlockSize; }
+  bool rtcUserMemoryRead(uint32_t offset, uint32_t *data, size_t size);
+  bool rtcUserMemoryWrite(uint32_t offset, uint32_t *data, size_t size);
+
+private:
+  uint8_t rtcUserMemory[RTC_USER_MEMORY_SIZE] = {};
+};
+
+extern EspClass ESP;
+
+#endif // ARDUINO_H
@@ -0,0 +1,409 @@
+#ifndef ARDUINOJSON_H
+#define ARDUINOJSON_H
+
+// Host stand-in for the part of ArduinoJson 6 used by JSONAPIClient and the log
+// sinks: flat objects of strings, numbers and booleans. Nested values are kept
+// as raw JSON text. Not a general purpose JSON library.
+
+#include "Arduino.h"
+
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#define JSON_OBJECT_SIZE(n) ((n) * 16)
+
+class JsonDocument;
+
+class JsonVariant
+{
+public:
+  JsonVariant(JsonDocument *document, const char *key) : document(document), key(key) {}
+
+  JsonVariant &operator=(const char *value) { return set(value != nullptr ? value : "", true); }
+  JsonVariant &operator=(const String &value) { return set(value.c_str(), true); }
+  JsonVariant &operator=(bool value) { return set(value ? "true" : "false", false); }
+  template <typename T, typename std::enable_if<std::is_arithmetic<T>::value, int>::type = 0>
+  JsonVariant &operator=(T value)
+  {
+    return set(std::is_floating_point<T>::value ? std::to_string((double)value) : std::to_string((long long)value), false);
+  }
+
+  template <typename T>
+  T as() const;
+  bool isNull() const;
+
+private:
+  JsonDocument *document;
+  const char *key;
+
+  JsonVariant &set(const std::string &value, bool isString);
+};
+
+struct JsonString
+{
+  const char *text;
+  const char *c_str() const { return text; }
+};
+
+class JsonPair
+{
+public:
+  JsonPair(JsonDocument *document, const char *key) : name{key}, variant(document, key) {}
+  JsonString key() const { return name; }
+  JsonVariant value() const { return variant; }
+
+private:
+  JsonString name;
+  JsonVariant variant;
+};
+
+class JsonObject
+{
+public:
+  class Iterator
+  {
+  public:
+    Iterator(JsonDocument *document, size_t index) : document(document), index(index) {}
+    JsonPair operator*() const;
+    Iterator &operator++() { index++; return *this; }
+    bool operator!=(const Iterator &other) const { return index != other.index; }
+
+  private:
+    JsonDocument *document;
+    size_t index;
+  };
+
+  explicit JsonObject(JsonDocument *document) : document(document) {}
+  Iterator begin() const { return Iterator(document, 0); }
+  Iterator end() const;
+
+private:
+  JsonDocument *document;
+};
+
+class JsonDocument
+{
+public:
+  struct Member
+  {
+    std::string key;
+    std::string value; // unescaped for strings, JSON text otherwise
+    bool isString;
+  };
+
+  virtual ~JsonDocument() {}
+
+  JsonVariant operator[](const char *key) { return JsonVariant(this, key); }
+  bool containsKey(const char *key) const { return find(key) != nullptr; }
+  size_t size() const { return members.size(); }
+  void clear() { members.clear(); }
+  template <typename T>
+  T as() { return T(this); }
+
+  const Member *find(const char *key) const
+  {
+    for (const Member &member : members)
+      if (member.key == key)
+        return &member;
+    return nullptr;
+  }
+  Member &add(const char *key)
+  {
+    for (Member &member : members)
+      if (member.key == key)
+        return member;
+    members.push_back({key, "", false});
+    return members.back();
+  }
+
+  std::vector<Member> members;
+};
+
+template <size_t capacity>
+class StaticJsonDocument : public JsonDocument
+{
+};
+
+class DynamicJsonDocument : public JsonDocument
+{
+public:
+  explicit DynamicJsonDocument(size_t) {}
+};
+
+inline JsonPair JsonObject::Iterator::operator*() const { return JsonPair(document, document->members[index].key.c_str()); }
+inline JsonObject::Iterator JsonObject::end() const { return Iterator(document, document->members.size()); }
+
+inline JsonVariant &JsonVariant::set(const std::string &value, bool isString)
+{
+  JsonDocument::Member &member = document->add(key);
+  member.value = value;
+  member.isString = isString;
+  return *this;
+}
+
+inline bool JsonVariant::isNull() const
+{
+  const JsonDocument::Member *member = document->find(key);
+  return member == nullptr || (!member->isString && member->value == "null");
+}
+
+template <typename T>
+inline T JsonVariant::as() const
+{
+  const JsonDocument::Member *member = document->find(key);
+  if constexpr (std::is_same<T, const char *>::value)
+    return member != nullptr && member->isString ? member->value.c_str() : nullptr;
+  else if constexpr (std::is_same<T, bool>::value)
+    return member != nullptr && member->value == "true";
+  else if constexpr (std::is_floating_point<T>::value)
+    return member != nullptr ? (T)strtod(member->value.c_str(), nullptr) : 0;
+  else
+    return member != nullptr ? (T)strtoll(member->value.c_str(), nullptr, 10) : 0;
+}
+
+class DeserializationError
+{
+public:
+  enum Code
+  {
+    Ok,
+    EmptyInput,
+    InvalidInput
+  };
+
+  DeserializationError(Code code = Ok) : code(code) {}
+  explicit operator bool() const { return code != Ok; }
+  const char *c_str() const { return code == Ok ? "Ok" : code == EmptyInput ? "EmptyInput" : "InvalidInput"; }
+
+private:
+  Code code;
+};
+
+namespace DeserializationOption
+{
+  struct Filter
+  {
+    explicit Filter(const JsonDocument &filter) : filter(filter) {}
+    const JsonDocument &filter;
+  };
+}
+
+namespace ArduinoJsonHost
+{
+  inline void appendString(std::string &out, const std::string &value)
+  {
+    out += '"';
+    for (unsigned char c : value)
+    {
+      if (c == '"' || c == '\\')
+      {
+        out += '\\';
+        out += (char)c;
+      }
+      else if (c == '\n')
+        out += "\\n";
+      else if (c == '\r')
+        out += "\\r";
+      else if (c == '\t')
+        out += "\\t";
+      else if (c < 0x20)
+      {
+        char escaped[8];
+        snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+        out += escaped;
+      }
+      else
+        out += (char)c;
+    }
+    out += '"';
+  }
+
+  inline std::string serialize(const JsonDocument &document)
+  {
+    std::string out = "{";
+    for (const JsonDocument::Member &member : document.members)
+    {
+      if (out.size() > 1)
+        out += ',';
+      appendString(out, member.key);
+      out += ':';
+      if (member.isString)
+        appendString(out, member.value);
+      else
+        out += member.value;
+    }
+    return out + "}";
+  }
+
+  inline void skipSpace(const std::string &in, size_t &position)
+  {
+    while (position < in.size() && isspace((unsigned char)in[position]))
+      position++;
+  }
+
+  inline bool parseString(const std::string &in, size_t &position, std::string &out)
+  {
+    if (position >= in.size() || in[position] != '"')
+      return false;
+    for (position++; position < in.size(); position++)
+    {
+      char c = in[position];
+      if (c == '"')
+      {
+        position++;
+        return true;
+      }
+      if (c != '\\')
+      {
+        out += c;
+        continue;
+      }
+      if (++position >= in.size())
+        return false;
+      switch (in[position])
+      {
+      case 'n': out += '\n'; break;
+      case 'r': out += '\r'; break;
+      case 't': out += '\t'; break;
+      case 'b': out += '\b'; break;
+      case 'f': out += '\f'; break;
+      case 'u':
+        if (position + 4 >= in.size())
+          return false;
+        out += (char)strtol(in.substr(position + 1, 4).c_str(), nullptr, 16);
+        position += 4;
+        break;
+      default: out += in[position];
+      }
+    }
+    return false;
+  }
+
+  // A value other than a string as its JSON text, nested values included
+  inline bool parseRaw(const std::string &in, size_t &position, std::string &out)
+  {
+    size_t start = position;
+    int depth = 0;
+    bool quoted = false;
+    for (; position < in.size(); position++)
+    {
+      char c = in[position];
+      if (quoted)
+      {
+        if (c == '\\')
+          position++;
+        else if (c == '"')
+          quoted = false;
+      }
+      else if (c == '"')
+        quoted = true;
+      else if (c == '{' || c == '[')
+        depth++;
+      else if ((c == '}' || c == ']') && depth > 0)
+        depth--;
+      else if (depth == 0 && (c == ',' || c == '}' || isspace((unsigned char)c)))
+        break;
+    }
+    out = in.substr(start, position - start);
+    return !out.empty() && depth == 0;
+  }
+
+  inline DeserializationError parse(JsonDocument &document, const std::string &in, const JsonDocument *filter)
+  {
+    document.clear();
+    size_t position = 0;
+    skipSpace(in, position);
+    if (position == in.size())
+      return DeserializationError::EmptyInput;
+    if (in[position++] != '{')
+      return DeserializationError::InvalidInput;
+    skipSpace(in, position);
+    if (position < in.size() && in[position] == '}')
+      return DeserializationError::Ok;
+    for (;;)
+    {
+      std::string key;
+      std::string value;
+      skipSpace(in, position);
+      if (!parseString(in, position, key))
+        return DeserializationError::InvalidInput;
+      skipSpace(in, position);
+      if (position >= in.size() || in[position++] != ':')
+        return DeserializationError::InvalidInput;
+      skipSpace(in, position);
+      bool isString = position < in.size() && in[position] == '"';
+      if (!(isString ? parseString(in, position, value) : parseRaw(in, position, value)))
+        return DeserializationError::InvalidInput;
+      if (filter == nullptr || filter->containsKey(key.c_str()))
+      {
+        JsonDocument::Member &member = document.add(key.c_str());
+        member.value = value;
+        member.isString = isString;
+      }
+      skipSpace(in, position);
+      if (position >= in.size())
+        return DeserializationError::InvalidInput;
+      char c = in[position++];
+      if (c == '}')
+        return DeserializationError::Ok;
+      if (c != ',')
+        return DeserializationError::InvalidInput;
+    }
+  }
+
+  inline std::string readAll(Stream &input)
+  {
+    std::string in;
+    int c;
+    while ((c = input.read()) >= 0)
+      in += (char)c;
+    return in;
+  }
+}
+
+inline size_t measureJson(const JsonDocument &document) { return ArduinoJsonHost::serialize(document).size(); }
+
+inline size_t serializeJson(const JsonDocument &document, String &out)
+{
+  out = String(ArduinoJsonHost::serialize(document));
+  return out.length();
+}
+
+inline size_t serializeJson(const JsonDocument &document, Print &out)
+{
+  std::string text = ArduinoJsonHost::serialize(document);
+  return out.write((const uint8_t *)text.data(), text.size());
+}
+
+inline size_t serializeJson(const JsonDocument &document, char *out, size_t capacity)
+{
+  std::string text = ArduinoJsonHost::serialize(document);
+  if (capacity == 0)
+    return 0;
+  size_t length = text.size() < capacity - 1 ? text.size() : capacity - 1;
+  memcpy(out, text.data(), length);
+  out[length] = 0;
+  return length;
+}
+
+inline size_t serializeJsonPretty(const JsonDocument &document, Print &out) { return serializeJson(document, out); }
+
+inline DeserializationError deserializeJson(JsonDocument &document, const char *in)
+{
+  return ArduinoJsonHost::parse(document, in, nullptr);
+}
+inline DeserializationError deserializeJson(JsonDocument &document, const String &in)
+{
+  return ArduinoJsonHost::parse(document, in.c_str(), nullptr);
+}
+inline DeserializationError deserializeJson(JsonDocument &document, Stream &in)
+{
+  return ArduinoJsonHost::parse(document, ArduinoJsonHost::readAll(in), nullptr);
+}
+inline DeserializationError deserializeJson(JsonDocument &document, Stream &in, DeserializationOption::Filter filter)
+{
+  return ArduinoJsonHost::parse(document, ArduinoJsonHost::readAll(in), &filter.filter);
+}
+
+#endif // ARDUINOJSON_H
@@ -0,0 +1,90 @@
+#include "ESP8266HTTPClient.h"
+
+#include <strings.h>
+
+std::vector<HttpServerStub::Request> HttpServerStub::requests;
+std::vector<HttpServerStub::Response> HttpServerStub::responses;
+uint32_t HttpServerStub::connections = 0;
+bool HttpServerStub::keepAlive = true;
+
+void HttpServerStub::reset()
+{
+  requests.clear();
+  responses.clear();
+  connections = 0;
+  keepAlive = true;
+}
+
+std::string HttpServerStub::Request::header(const char *name) const
+{
+  for (const auto &header : headers)
+    if (strcasecmp(header.first.c_str(), name) == 0)
+      return header.second;
+  return std::string();
+}
+
+bool HTTPClient::begin(WiFiClient &, const String &url)
+{
+  end();
+  this->url = url.c_str();
+  return true;
+}
+
+bool HTTPClient::setURL(const String &url)
+{
+  this->url = url.c_str();
+  return true;
+}
+
+int HTTPClient::sendRequest(const char *type, Stream *stream, size_t size)
+{
+  std::string body;
+  uint8_t buffer[128];
+  while (body.size() < size)
+  {
+    size_t length = size - body.size() < sizeof(buffer) ? size - body.size() : sizeof(buffer);
+    int read = stream->read(buffer, length);
+    if (read <= 0)
+      break;
+    body.append((const char *)buffer, read);
+  }
+  return send(type, body);
+}
+
+int HTTPClient::sendRequest(const char *type, const uint8_t *payload, size_t size)
+{
+  return send(type, payload != nullptr ? std::string((const char *)payload, size) : std::string());
+}
+
+int HTTPClient::send(const char *method, const std::string &body)
+{
+  bool reused = open;
+  if (!open)
+  {
+    HttpServerStub::connections++;
+    open = true;
+  }
+  HttpServerStub::requests.push_back({method, url, authorization, headers, body, reused});
+
+  HttpServerStub::Response answer = {HTTP_CODE_OK, "{}"};
+  if (!HttpServerStub::responses.empty())
+  {
+    answer = HttpServerStub::responses.front();
+    HttpServerStub::responses.erase(HttpServerStub::responses.begin());
+  }
+  if (answer.code < 0 || !HttpServerStub::keepAlive)
+    open = false;
+
+  std::shared_ptr<ClientState> state = std::make_shared<ClientState>();
+  state->input = answer.body;
+  response = WiFiClient(state);
+  return answer.code;
+}
+
+void HTTPClient::end()
+{
+  // the request headers are cleared, a kept connection stays open
+  headers.clear();
+  if (!reuse)
+    open = false;
+}
@@ -0,0 +1,85 @@
+#ifndef ESP8266HTTPCLIENT_H
+#define ESP8266HTTPCLIENT_H
+
+// Host stand-in for HTTPClient with a scripted server behind it: every request is
+// recorded in HttpServerStub::requests and answered with the next entry of
+// HttpServerStub::responses (200 with an empty JSON object when there is none).
+// A negative response code fails the request like a lost connection.
+
+#include "Arduino.h"
+#include "ESP8266WiFi.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+enum t_http_codes
+{
+  HTTP_CODE_OK = 200,
+  HTTP_CODE_BAD_REQUEST = 400,
+  HTTP_CODE_INTERNAL_SERVER_ERROR = 500
+};
+
+#define HTTPC_ERROR_CONNECTION_FAILED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+
+struct HttpServerStub
+{
+  struct Request
+  {
+    std::string method;
+    std::string url;
+    std::string authorization;
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+    bool reused; // sent over a connection kept from a previous request
+
+    std::string header(const char *name) const;
+  };
+  struct Response
+  {
+    int code;
+    std::string body;
+  };
+
+  static std::vector<Request> requests;
+  static std::vector<Response> responses;
+  static uint32_t connections; // connections opened
+  static bool keepAlive;       // the server keeps connections open after a response
+
+  static void reset();
+};
+
+class HTTPClient
+{
+public:
+  bool begin(WiFiClient &client, const String &url);
+  bool setURL(const String &url);
+  void setReuse(bool enable) { reuse = enable; }
+  void setAuthorization(const char *value) { authorization = value; }
+  void addHeader(const String &name, const String &value) { headers.push_back({name.c_str(), value.c_str()}); }
+
+  int GET() { return send("GET", std::string()); }
+  int sendRequest(const char *type, Stream *stream, size_t size);
+  int sendRequest(const char *type, const uint8_t *payload = nullptr, size_t size = 0);
+
+  WiFiClient &getStream() { return response; }
+  bool connected() { return open; }
+  void end();
+  static String errorToString(int error) { return String("HTTPC_ERROR ") + String(error); }
+
+private:
+  std::string url;
+  std::string authorization;
+  std::vector<std::pair<std::string, std::string>> headers;
+  bool reuse = false;
+  bool open = false;
+  WiFiClient response;
+
+  int send(const char *method, const std::string &body);
+};
+
+#endif // ESP8266HTTPCLIENT_H
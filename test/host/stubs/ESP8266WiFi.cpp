@@ -0,0 +1,4 @@
+#include "ESP8266WiFi.h"
+
+bool WiFiClient::refuseConnections = false;
+std::vector<std::shared_ptr<ClientState>> WiFiClient::connections;
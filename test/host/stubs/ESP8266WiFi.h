@@ -0,0 +1,87 @@
+#ifndef ESP8266WIFI_H
+#define ESP8266WIFI_H
+
+// Host stand-in for the WiFiServer/WiFiClient parts used by the network sinks.
+// Connections are scripted through ClientState: the test queues them at the
+// server (or gets them from WiFiClient::connections after connect()), sets their
+// send window and input, and reads what was sent.
+
+#include "Arduino.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+struct ClientState
+{
+  bool connected = true;
+  size_t room = 1 << 16; // send window, see availableForWrite()
+  std::string sent;
+  std::string input; // what the peer sends, read by read()
+  size_t inputPosition = 0;
+};
+
+class WiFiClient : public Stream
+{
+public:
+  // connect() fails while refuseConnections is set, otherwise opens a new connection
+  static bool refuseConnections;
+  static std::vector<std::shared_ptr<ClientState>> connections;
+
+  WiFiClient() {}
+  explicit WiFiClient(std::shared_ptr<ClientState> state) : state(state) {}
+  virtual ~WiFiClient() {}
+
+  int connect(const char *, uint16_t)
+  {
+    if (refuseConnections)
+      return 0;
+    state = std::make_shared<ClientState>();
+    connections.push_back(state);
+    return 1;
+  }
+  explicit operator bool() const { return state && state->connected; }
+  uint8_t connected() { return state && state->connected; }
+  void stop() { state.reset(); }
+  void setNoDelay(bool) {}
+  void setTimeout(unsigned long) {}
+
+  int availableForWrite() override { return state && state->connected ? (int)state->room : 0; }
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *buffer, size_t size) override
+  {
+    if (!state || !state->connected)
+      return 0;
+    if (size > state->room)
+      size = state->room;
+    state->sent.append((const char *)buffer, size);
+    state->room -= size;
+    return size;
+  }
+  using Print::write;
+  int available() override { return state ? (int)(state->input.size() - state->inputPosition) : 0; }
+  int read() override { return available() > 0 ? (uint8_t)state->input[state->inputPosition++] : -1; }
+  int peek() override { return available() > 0 ? (uint8_t)state->input[state->inputPosition] : -1; }
+  using Stream::read;
+
+private:
+  std::shared_ptr<ClientState> state;
+};
+
+class WiFiServer
+{
+public:
+  explicit WiFiServer(uint16_t) {}
+  void begin(uint16_t) {}
+  bool hasClient() { return !pending.empty(); }
+  WiFiClient accept()
+  {
+    WiFiClient client(pending.front());
+    pending.erase(pending.begin());
+    return client;
+  }
+
+  std::vector<std::shared_ptr<ClientState>> pending; // connections to accept
+};
+
+#endif // ESP8266WIFI_H
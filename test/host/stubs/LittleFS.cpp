@@ -0,0 +1,35 @@
+#include "LittleFS.h"
+
+LittleFSClass LittleFS;
+
+File LittleFSClass::open(const String &path, const char *mode)
+{
+  auto file = files.find(path.c_str());
+  if (mode[0] == 'r')
+    return file != files.end() ? File(file->second, false) : File();
+  if (file == files.end() || mode[0] == 'w')
+    file = files.insert_or_assign(path.c_str(), std::make_shared<std::string>()).first;
+  return File(file->second, true);
+}
+
+Dir::Dir(const std::map<std::string, std::shared_ptr<std::string>> &files, const std::string &directory)
+  : files(files), prefix(directory + "/")
+{
+}
+
+// Steps to the next file directly in the directory
+bool Dir::next()
+{
+  if (started && current == files.end())
+    return false;
+  current = started ? std::next(current) : files.lower_bound(prefix);
+  started = true;
+  while (current != files.end() && current->first.compare(0, prefix.size(), prefix) == 0)
+  {
+    if (current->first.find('/', prefix.size()) == std::string::npos)
+      return true;
+    ++current;
+  }
+  current = files.end();
+  return false;
+}
@@ -0,0 +1,73 @@
+#ifndef LITTLEFS_H
+#define LITTLEFS_H
+
+// Host stand-in for LittleFS: files live in memory for the whole test run,
+// like flash content survives a reset
+
+#include "Arduino.h"
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+
+class File
+{
+public:
+  File() {}
+  File(std::shared_ptr<std::string> content, bool append) : content(content), position(append ? content->size() : 0) {}
+
+  explicit operator bool() const { return content != nullptr; }
+  size_t write(const uint8_t *buffer, size_t size)
+  {
+    content->append((const char *)buffer, size);
+    return size;
+  }
+  size_t read(uint8_t *buffer, size_t size)
+  {
+    size_t length = content->size() - position < size ? content->size() - position : size;
+    memcpy(buffer, content->data() + position, length);
+    position += length;
+    return length;
+  }
+  size_t size() const { return content != nullptr ? content->size() : 0; }
+  void close() { content.reset(); }
+
+private:
+  std::shared_ptr<std::string> content;
+  size_t position = 0;
+};
+
+class Dir
+{
+public:
+  Dir(const std::map<std::string, std::shared_ptr<std::string>> &files, const std::string &directory);
+  bool next();
+  String fileName() const { return String(current->first.substr(prefix.size())); }
+  size_t fileSize() const { return current->second->size(); }
+
+private:
+  const std::map<std::string, std::shared_ptr<std::string>> &files;
+  std::string prefix;
+  std::map<std::string, std::shared_ptr<std::string>>::const_iterator current;
+  bool started = false;
+};
+
+class LittleFSClass
+{
+public:
+  bool exists(const String &path) const { return directories.count(path.c_str()) > 0 || files.count(path.c_str()) > 0; }
+  bool mkdir(const String &path) { directories.insert(path.c_str()); return true; }
+  bool remove(const String &path) { return files.erase(path.c_str()) > 0; }
+  File open(const String &path, const char *mode);
+  Dir openDir(const String &path) const { return Dir(files, path.c_str()); }
+  void format() { files.clear(); directories.clear(); }
+
+private:
+  std::map<std::string, std::shared_ptr<std::string>> files;
+  std::set<std::string> directories;
+};
+
+extern LittleFSClass LittleFS;
+
+#endif // LITTLEFS_H
@@ -0,0 +1,23 @@
+#ifndef STREAMDEV_H
+#define STREAMDEV_H
+
+#include "Arduino.h"
+
+// Read-only stream over a constant buffer, as in the ESP8266 core
+class StreamConstPtr : public Stream
+{
+public:
+  StreamConstPtr(const uint8_t *buffer, size_t size) : buffer(buffer), size(size) {}
+
+  int available() override { return size - position; }
+  int read() override { return position < size ? buffer[position++] : -1; }
+  int peek() override { return position < size ? buffer[position] : -1; }
+  size_t write(uint8_t) override { return 0; }
+
+private:
+  const uint8_t *buffer;
+  size_t size;
+  size_t position = 0;
+};
+
+#endif // STREAMDEV_H
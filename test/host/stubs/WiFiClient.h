@@ -0,0 +1,6 @@
+#ifndef WIFICLIENT_H
+#define WIFICLIENT_H
+
+#include "ESP8266WiFi.h"
+
+#endif // WIFICLIENT_H
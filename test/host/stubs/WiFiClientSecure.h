@@ -0,0 +1,12 @@
+#ifndef WIFICLIENTSECURE_H
+#define WIFICLIENTSECURE_H
+
+#include "ESP8266WiFi.h"
+
+class WiFiClientSecure : public WiFiClient
+{
+public:
+  void setInsecure() {}
+};
+
+#endif // WIFICLIENTSECURE_H
@@ -0,0 +1,28 @@
+#ifndef BASE64_H
+#define BASE64_H
+
+#include "Arduino.h"
+
+class base64
+{
+public:
+  static String encode(const String &text, bool doNewLines = true)
+  {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    (void)doNewLines; // only used for inputs longer than 72 bytes
+    const uint8_t *in = (const uint8_t *)text.c_str();
+    size_t length = text.length();
+    std::string out;
+    for (size_t i = 0; i < length; i += 3)
+    {
+      uint32_t group = in[i] << 16 | (i + 1 < length ? in[i + 1] << 8 : 0) | (i + 2 < length ? in[i + 2] : 0);
+      out += alphabet[group >> 18 & 63];
+      out += alphabet[group >> 12 & 63];
+      out += i + 1 < length ? alphabet[group >> 6 & 63] : '=';
+      out += i + 2 < length ? alphabet[group & 63] : '=';
+    }
+    return String(out);
+  }
+};
+
+#endif // BASE64_H
@@ -0,0 +1,27 @@
+#ifndef COREDECLS_H
+#define COREDECLS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-32 as computed by the ESP8266 core (MSB first, polynomial 0x04C11DB7)
+inline uint32_t crc32(const void *data, size_t length, uint32_t crc = 0xffffffff)
+{
+  const uint8_t *bytes = (const uint8_t *)data;
+  while (length--)
+  {
+    uint8_t c = *bytes++;
+    for (uint32_t i = 0x80; i > 0; i >>= 1)
+    {
+      bool bit = crc & 0x80000000;
+      if (c & i)
+        bit = !bit;
+      crc <<= 1;
+      if (bit)
+        crc ^= 0x04c11db7;
+    }
+  }
+  return crc;
+}
+
+#endif // COREDECLS_H
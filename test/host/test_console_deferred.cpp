@@ -0,0 +1,116 @@
+// Deferred log queue: records keep their order across the ring wraparound, %s
+// arguments survive as whole pointers, a full queue drops and reports, and
+// drainDeferred() stops after its time budget
+#include "Console.h"
+#include "check.h"
+
+#include <string>
+
+// Each line takes 1 ms of simulated time to write
+class SlowStream : public Stream
+{
+public:
+  std::string text;
+  size_t lines = 0;
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *buffer, size_t size) override
+  {
+    text.append((const char *)buffer, size);
+    lines++;
+    advanceMillis(1);
+    return size;
+  }
+  using Print::write;
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+};
+
+static size_t count(const std::string &text, const char *part)
+{
+  size_t found = 0;
+  for (size_t position = text.find(part); position != std::string::npos; position = text.find(part, position + 1))
+    found++;
+  return found;
+}
+
+// the capacity of the ring is one less than its size
+static const size_t CAPACITY = 15;
+
+int main()
+{
+  Console console;
+  console.removeSink(Serial);
+  console.setDeduplicate(false);
+  console.setLogLevel(Console::DEBUG);
+  SlowStream out;
+  CHECK(console.addSink(out, Console::DEBUG));
+
+  // wraparound: head and tail pass the end of the ring several times
+  static const char *names[] = {"alpha", "bravo", "charlie"};
+  int next = 0;
+  for (int round = 0; round < 10; round++)
+  {
+    for (int i = 0; i < 7; i++, next++)
+      CHECK(console.logDeferred(Console::INFO, F("Deferred %d %s %u %d"), next, names[next % 3], (unsigned)next * 1000u, -next));
+    CHECK(console.drainDeferred() == 0);
+  }
+  bool ordered = true;
+  size_t position = 0;
+  for (int i = 0; i < next; i++)
+  {
+    char line[64];
+    snprintf(line, sizeof(line), "Deferred %d %s %u %d\n", i, names[i % 3], (unsigned)i * 1000u, -i);
+    size_t found = out.text.find(line, position);
+    if (found == std::string::npos)
+      ordered = false;
+    else
+      position = found;
+  }
+  CHECK(ordered);
+  CHECK(out.lines == (size_t)next);
+
+  // full queue: the record that does not fit is dropped and counted
+  out.text.clear();
+  out.lines = 0;
+  for (size_t i = 0; i < CAPACITY; i++)
+    CHECK(console.logDeferred(Console::INFO, F("Queued %u"), (unsigned)i));
+  CHECK(!console.logDeferred(Console::INFO, F("Queued %u"), 99u));
+  CHECK(!console.logDeferred(Console::INFO, F("Queued %u"), 100u));
+  CHECK(console.drainDeferred() == 0);
+  CHECK(count(out.text, "Queued ") == CAPACITY);
+  CHECK(count(out.text, "Queued 99") == 0);
+  CHECK(count(out.text, "Deferred log queue full, dropped 2 records") == 1);
+  // the drop count starts over
+  out.text.clear();
+  CHECK(console.logDeferred(Console::INFO, F("Queued %u"), 200u));
+  CHECK(console.drainDeferred() == 0);
+  CHECK(count(out.text, "dropped") == 0);
+
+  // budget: 1 ms per line, the drain stops after the line that used the budget up
+  out.text.clear();
+  out.lines = 0;
+  for (size_t i = 0; i < 10; i++)
+    CHECK(console.logDeferred(Console::INFO, F("Budget %u"), (unsigned)i));
+  CHECK(console.drainDeferred(2500) == 7);
+  CHECK(out.lines == 3);
+  CHECK(count(out.text, "Budget 2\n") == 1);
+  CHECK(count(out.text, "Budget 3\n") == 0);
+  // space freed by a partial drain is usable at once, the rest keeps its order
+  for (size_t i = 10; i < 10 + CAPACITY - 7; i++)
+    CHECK(console.logDeferred(Console::INFO, F("Budget %u"), (unsigned)i));
+  CHECK(!console.logDeferred(Console::INFO, F("Budget %u"), 99u));
+  CHECK(console.drainDeferred(0) == 0);
+  CHECK(out.text.find("Budget 3\n") < out.text.find("Budget 10\n"));
+  CHECK(count(out.text, "Budget ") == 10 + CAPACITY - 7);
+
+  // below the log level nothing is queued
+  console.setLogLevel(Console::WARNING);
+  out.lines = 0;
+  CHECK(console.logDeferred(Console::DEBUG, F("Hidden %d"), 1));
+  CHECK(console.drainDeferred() == 0);
+  CHECK(out.lines == 0);
+
+  return CHECK_RESULT();
+}
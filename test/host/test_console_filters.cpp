@@ -0,0 +1,205 @@
+// Deduplication of repeated lines and rate limiting per call site, with their
+// summary lines and the plain print output following a suppressed line
+#include "Console.h"
+#include "check.h"
+
+#include <string>
+
+class CaptureStream : public Stream
+{
+public:
+  std::string text;
+
+  size_t write(uint8_t c) override { text += (char)c; return 1; }
+  size_t write(const uint8_t *buffer, size_t size) override { text.append((const char *)buffer, size); return size; }
+  using Print::write;
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+};
+
+static size_t count(const std::string &text, const char *part)
+{
+  size_t found = 0;
+  for (size_t position = text.find(part); position != std::string::npos; position = text.find(part, position + 1))
+    found++;
+  return found;
+}
+
+// true if first occurs and second occurs after it
+static bool before(const std::string &text, const char *first, const char *second)
+{
+  size_t position = text.find(first);
+  return position != std::string::npos && text.find(second, position) != std::string::npos;
+}
+
+static void deduplication()
+{
+  Console console;
+  console.removeSink(Serial);
+  console.setLogLevel(Console::DEBUG);
+  CaptureStream out;
+  CHECK(console.addSink(out, Console::DEBUG));
+
+  // identical lines are counted, not written
+  for (int i = 0; i < 4; i++)
+    console.log(Console::INFO, F("WiFi lost, retry %d"), 1);
+  CHECK(count(out.text, "WiFi lost, retry 1") == 1);
+  CHECK(count(out.text, "repeated") == 0);
+
+  // a different message writes the count before itself
+  console.log(Console::INFO, F("WiFi connected"));
+  CHECK(count(out.text, "Last message repeated 3 times") == 1);
+  CHECK(before(out.text, "Last message repeated 3 times", "WiFi connected"));
+
+  // the same format with other arguments is a different message
+  console.log(Console::INFO, F("WiFi lost, retry %d"), 1);
+  console.log(Console::INFO, F("WiFi lost, retry %d"), 2);
+  console.log(Console::INFO, F("WiFi lost, retry %d"), 2);
+  CHECK(count(out.text, "WiFi lost, retry 1") == 2);
+  CHECK(count(out.text, "WiFi lost, retry 2") == 1);
+
+  // strings are compared by content
+  char name[8] = "alpha";
+  console.log(Console::INFO, F("Host %s"), name);
+  strcpy(name, "bravo");
+  console.log(Console::INFO, F("Host %s"), name);
+  CHECK(count(out.text, "Host alpha") == 1);
+  CHECK(count(out.text, "Host bravo") == 1);
+  CHECK(count(out.text, "Last message repeated 1 times") == 1); // the second "retry 2"
+
+  // the same message at another level is not a repeat
+  console.log(Console::WARNING, F("Host %s"), name);
+  CHECK(count(out.text, "Host bravo") == 2);
+
+  // a pending count is written when deduplication is switched off
+  console.log(Console::WARNING, F("Host %s"), name);
+  console.setDeduplicate(false);
+  CHECK(count(out.text, "Last message repeated 1 times") == 2);
+  console.log(Console::WARNING, F("Host %s"), name);
+  CHECK(count(out.text, "Host bravo") == 3);
+}
+
+static void rateLimit()
+{
+  Console console;
+  console.removeSink(Serial);
+  console.setDeduplicate(false);
+  console.setLogLevel(Console::DEBUG);
+  CaptureStream out;
+  CHECK(console.addSink(out, Console::DEBUG));
+  console.setRateLimit(2, 1000);
+
+  // two lines per window, the rest is counted
+  for (int i = 0; i < 5; i++)
+    console.log(Console::DEBUG, F("Poll %d"), i);
+  CHECK(count(out.text, "Poll ") == 2);
+  CHECK(count(out.text, "suppressed") == 0);
+
+  // the count is written when the next window starts, before its first line
+  advanceMillis(1000);
+  console.log(Console::DEBUG, F("Poll %d"), 5);
+  CHECK(count(out.text, "Rate limit suppressed 3 lines of \"Poll %d\"") == 1);
+  CHECK(before(out.text, "Rate limit suppressed 3 lines", "Poll 5"));
+
+  // the summary has the highest level of the suppressed lines
+  console.log(Console::DEBUG, F("Poll %d"), 6);
+  console.log(Console::ERROR, F("Poll %d"), 7);
+  console.log(Console::DEBUG, F("Poll %d"), 8);
+  out.text.clear();
+  advanceMillis(1000);
+  console.log(Console::DEBUG, F("Poll %d"), 9);
+  CHECK(count(out.text, "Rate limit suppressed 2 lines") == 1);
+  std::string summary = out.text.substr(0, out.text.find('\n'));
+  CHECK(count(summary, "ERROR") == 1 && count(summary, "suppressed") == 1);
+}
+
+static void rateLimitSlots()
+{
+  // 9 call sites: each needs its own format string
+  static const char *const formats[] = {
+    "Site 0 %d", "Site 1 %d", "Site 2 %d", "Site 3 %d", "Site 4 %d",
+    "Site 5 %d", "Site 6 %d", "Site 7 %d", "Site 8 %d",
+  };
+  CHECK(sizeof(formats) / sizeof(formats[0]) == Console::RATE_LIMIT_SLOTS + 1);
+
+  Console console;
+  console.removeSink(Serial);
+  console.setDeduplicate(false);
+  console.setLogLevel(Console::DEBUG);
+  CaptureStream out;
+  CHECK(console.addSink(out, Console::DEBUG));
+  console.setRateLimit(1, 10000);
+
+  // fill the 8 slots, one suppressed line each, windows started 10 ms apart
+  for (uint8_t site = 0; site < Console::RATE_LIMIT_SLOTS; site++)
+  {
+    console.log(Console::INFO, F(formats[site]), 1);
+    console.log(Console::INFO, F(formats[site]), 2);
+    advanceMillis(10);
+  }
+  CHECK(count(out.text, " 1\n") == Console::RATE_LIMIT_SLOTS);
+  CHECK(count(out.text, " 2\n") == 0);
+  CHECK(count(out.text, "suppressed") == 0);
+
+  // a ninth site takes the slot with the oldest window and writes its count first
+  out.text.clear();
+  console.log(Console::INFO, F(formats[8]), 1);
+  CHECK(count(out.text, "Rate limit suppressed 1 lines of \"Site 0 %d\"") == 1);
+  CHECK(before(out.text, "Site 0 %d", "Site 8 1"));
+  CHECK(count(out.text, "suppressed") == 1);
+
+  // the evicted site starts over in the next oldest slot, its window is new
+  out.text.clear();
+  console.log(Console::INFO, F(formats[0]), 3);
+  CHECK(count(out.text, "Rate limit suppressed 1 lines of \"Site 1 %d\"") == 1);
+  CHECK(count(out.text, "Site 0 3") == 1);
+
+  // the remaining counts are written when the limit changes
+  out.text.clear();
+  console.setRateLimit(0, 0);
+  for (uint8_t site = 2; site < Console::RATE_LIMIT_SLOTS; site++)
+  {
+    char summary[48];
+    snprintf(summary, sizeof(summary), "suppressed 1 lines of \"Site %u %%d\"", site);
+    CHECK(count(out.text, summary) == 1);
+  }
+  CHECK(count(out.text, "suppressed") == Console::RATE_LIMIT_SLOTS - 2);
+}
+
+static void plainOutputAfterSuppressedLine()
+{
+  Console console;
+  console.removeSink(Serial);
+  console.setLogLevel(Console::DEBUG);
+  CaptureStream all;
+  CaptureStream warnings;
+  CHECK(console.addSink(all, Console::DEBUG));
+  CHECK(console.addSink(warnings, Console::WARNING));
+  console.setRateLimit(1, 1000);
+
+  // a rate limited DEBUG line after a WARNING line: its dump stays DEBUG
+  console.log(Console::DEBUG, F("Response %d"), 1);
+  console.log(Console::WARNING, F("Slow response"));
+  console.log(Console::DEBUG, F("Response %d"), 2);
+  console.println("response dump");
+  CHECK(count(all.text, "response dump") == 1);
+  CHECK(count(warnings.text, "response dump") == 0);
+
+  // and for a line below every sink
+  CHECK(console.setSinkLevel(all, Console::INFO));
+  console.log(Console::WARNING, F("Disk full"));
+  console.log(Console::DEBUG, F("Free %d"), 10);
+  console.println("free dump");
+  CHECK(count(all.text, "free dump") == 0);
+  CHECK(count(warnings.text, "free dump") == 0);
+}
+
+int main()
+{
+  deduplication();
+  rateLimit();
+  rateLimitSlots();
+  plainOutputAfterSuppressedLine();
+  return CHECK_RESULT();
+}
@@ -0,0 +1,256 @@
+// Binary log records (RECORD_LOG 0xB1, RECORD_TEXT 0xB2) as written to a record
+// sink: header fields, the encoding of every argument width and of strings, and
+// the size limits. "test_console_records --dump" prints the records for
+// check_records_server.py, which expands them with format_record() and
+// decode_binary_log() of the log server and compares with printf on the host.
+#include "Console.h"
+#include "check.h"
+
+#include <string>
+#include <vector>
+
+class CaptureStream : public Stream
+{
+public:
+  std::string bytes;
+
+  size_t write(uint8_t c) override { bytes += (char)c; return 1; }
+  size_t write(const uint8_t *buffer, size_t size) override { bytes.append((const char *)buffer, size); return size; }
+  using Print::write;
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+};
+
+struct Record
+{
+  uint8_t type;
+  uint8_t level;
+  uint32_t time;
+  uint32_t format;
+  std::string data; // arguments of RECORD_LOG, text of RECORD_TEXT
+};
+
+static uint32_t le(const std::string &bytes, size_t position, size_t size)
+{
+  uint32_t value = 0;
+  for (size_t i = 0; i < size; i++)
+    value |= (uint32_t)(uint8_t)bytes[position + i] << (8 * i);
+  return value;
+}
+
+// Splits a record stream, false if it does not consist of whole records
+static bool parse(const std::string &bytes, std::vector<Record> &records)
+{
+  size_t position = 0;
+  while (position < bytes.size())
+  {
+    Record record = {};
+    record.type = (uint8_t)bytes[position];
+    size_t header;
+    size_t length;
+    if (record.type == Console::RECORD_LOG && bytes.size() - position >= Console::RECORD_LOG_HEADER_SIZE)
+    {
+      header = Console::RECORD_LOG_HEADER_SIZE;
+      record.level = (uint8_t)bytes[position + 1];
+      record.time = le(bytes, position + 2, 4);
+      record.format = le(bytes, position + 6, 4);
+      length = le(bytes, position + 10, 2);
+    }
+    else if (record.type == Console::RECORD_TEXT && bytes.size() - position >= Console::RECORD_TEXT_HEADER_SIZE)
+    {
+      header = Console::RECORD_TEXT_HEADER_SIZE;
+      length = le(bytes, position + 1, 2);
+    }
+    else
+      return false;
+    if (bytes.size() - position - header < length)
+      return false;
+    record.data = bytes.substr(position + header, length);
+    records.push_back(record);
+    position += header + length;
+  }
+  return true;
+}
+
+static std::string raw(std::initializer_list<uint8_t> bytes) { return std::string(bytes.begin(), bytes.end()); }
+
+template <typename T>
+static std::string raw(T value) { return std::string((const char *)&value, sizeof(value)); }
+
+// A log line with its format and the text printf makes of it
+struct Expected
+{
+  const char *format;
+  std::string text;
+};
+
+static std::vector<Expected> expected;
+static Console *console;
+
+#define LOG_RECORD(fmt, ...)                                                    \
+  do                                                                            \
+  {                                                                             \
+    static const char format[] = fmt;                                           \
+    char text[Console::LINE_BUFFER_MAX_SIZE];                                   \
+    snprintf(text, sizeof(text), format, ##__VA_ARGS__);                        \
+    expected.push_back({format, text});                                         \
+    console->log(Console::INFO, F(format), ##__VA_ARGS__);                      \
+  } while (0)
+
+static void logAll()
+{
+  // every argument width
+  LOG_RECORD("no arguments, 100%% literal");
+  LOG_RECORD("int %d %i", -5, 2147483647);
+  LOG_RECORD("unsigned %u %x %X %o", 4294967295u, 0xBEEFu, 0xCAFEu, 8u);
+  LOG_RECORD("short and char %hd %hhu", (short)-300, (unsigned char)200);
+  LOG_RECORD("char %c%c", 'o', 'k');
+  LOG_RECORD("long long %lld %llu %llx", -1234567890123LL, 18446744073709551615ULL, 0x123456789ABCULL);
+  LOG_RECORD("intmax %jd", (intmax_t)-42);
+  LOG_RECORD("double %f %.2f %e %g", 3.5, -0.125, 12345.678, 0.0001);
+  LOG_RECORD("width %5d|%-5d|%05d|%+d", 42, 42, 42, 42);
+  LOG_RECORD("star %*d|%.*f|%-*s|", 6, 7, 3, 2.71828, 8, "left");
+  // strings
+  LOG_RECORD("string %s and %s", "first", "");
+  LOG_RECORD("precision %.3s|%8s|", "truncated", "right");
+  LOG_RECORD("utf-8 %s", "Gr\xc3\xbc\xc3\x9f" "e");
+  LOG_RECORD("mixed %s=%d (%s) %.1f%%", "rssi", -67, "dBm", 99.5);
+}
+
+static void encoding()
+{
+  CaptureStream records;
+  CHECK(console->addSink(records, Console::DEBUG, Console::SINK_RECORDS));
+
+  time_t before = time(nullptr);
+  logAll();
+  std::vector<Record> parsed;
+  CHECK(parse(records.bytes, parsed));
+  CHECK(parsed.size() == expected.size());
+  for (size_t i = 0; i < parsed.size() && i < expected.size(); i++)
+  {
+    CHECK(parsed[i].type == Console::RECORD_LOG);
+    CHECK(parsed[i].level == Console::INFO);
+    CHECK(parsed[i].time >= (uint32_t)before && parsed[i].time <= (uint32_t)time(nullptr));
+    CHECK(parsed[i].format == (uint32_t)(uintptr_t)expected[i].format);
+  }
+
+  // the argument bytes, little endian as in the header
+  if (parsed.size() == expected.size())
+  {
+    CHECK(parsed[0].data.empty());
+    CHECK(parsed[1].data == raw({0xFB, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x7F}));
+    CHECK(parsed[3].data == raw({0xD4, 0xFE, 0xFF, 0xFF, 0xC8, 0x00, 0x00, 0x00})); // promoted to int
+    CHECK(parsed[4].data == raw({'o', 0, 0, 0, 'k', 0, 0, 0}));
+    CHECK(parsed[5].data == raw(-1234567890123LL) + raw(18446744073709551615ULL) + raw(0x123456789ABCULL));
+    CHECK(parsed[6].data == raw((long long)-42));
+    CHECK(parsed[7].data.size() == 4 * sizeof(double) && parsed[7].data.substr(0, 8) == raw(3.5));
+    CHECK(parsed[9].data == raw({6, 0, 0, 0, 7, 0, 0, 0, 3, 0, 0, 0}) + raw(2.71828) + raw({8, 0, 0, 0, 4}) + "left");
+    CHECK(parsed[10].data == raw({5}) + "first" + raw({0}));
+    CHECK(parsed[11].data == raw({9}) + "truncated" + raw({5}) + "right"); // precision is applied by the decoder
+  }
+  console->removeSink(records);
+}
+
+static void limits()
+{
+  CaptureStream records;
+  CaptureStream text;
+  CHECK(console->addSink(records, Console::DEBUG, Console::SINK_RECORDS));
+  CHECK(console->addSink(text, Console::DEBUG));
+
+  // strings are cut at 255 bytes, their length field is one byte
+  std::string longString(300, 'x');
+  console->log(Console::WARNING, F("long %s!"), longString.c_str());
+  std::vector<Record> parsed;
+  CHECK(parse(records.bytes, parsed));
+  CHECK(parsed.size() == 1);
+  if (parsed.size() == 1)
+  {
+    CHECK(parsed[0].level == Console::WARNING);
+    CHECK(parsed[0].data == raw({255}) + std::string(255, 'x'));
+  }
+
+  // arguments beyond LINE_BUFFER_MAX_SIZE: no record at all rather than a cut one,
+  // the text sinks still get the (truncated) line
+  records.bytes.clear();
+  text.bytes.clear();
+  std::string s(255, 's');
+  console->log(Console::INFO, F("%s%s%s%s%s"), s.c_str(), s.c_str(), s.c_str(), s.c_str(), s.c_str());
+  CHECK(records.bytes.empty());
+  CHECK(!text.bytes.empty() && text.bytes.size() <= Console::LINE_BUFFER_MAX_SIZE);
+  // the largest record that fits
+  std::string fit(Console::LINE_BUFFER_MAX_SIZE - Console::RECORD_LOG_HEADER_SIZE - 3 * 256 - 1, 'f');
+  console->log(Console::INFO, F("%s%s%s%s"), s.c_str(), s.c_str(), s.c_str(), fit.c_str());
+  parsed.clear();
+  CHECK(parse(records.bytes, parsed));
+  CHECK(parsed.size() == 1 && parsed[0].data.size() + Console::RECORD_LOG_HEADER_SIZE == Console::LINE_BUFFER_MAX_SIZE);
+
+  // plain print output becomes RECORD_TEXT records of at most one line buffer
+  records.bytes.clear();
+  std::string dump;
+  for (int i = 0; dump.size() < 3000; i++)
+    dump += "dump line " + std::to_string(i) + "\n";
+  console->print(dump.c_str());
+  parsed.clear();
+  CHECK(parse(records.bytes, parsed));
+  CHECK(parsed.size() > 1);
+  std::string joined;
+  for (const Record &record : parsed)
+  {
+    CHECK(record.type == Console::RECORD_TEXT);
+    CHECK(record.data.size() + Console::RECORD_TEXT_HEADER_SIZE <= Console::LINE_BUFFER_MAX_SIZE);
+    joined += record.data;
+  }
+  CHECK(joined == dump);
+
+  console->removeSink(records);
+  console->removeSink(text);
+}
+
+static std::string hex(const std::string &data)
+{
+  static const char digits[] = "0123456789abcdef";
+  std::string out;
+  for (unsigned char byte : data)
+  {
+    out += digits[byte >> 4];
+    out += digits[byte & 0x0F];
+  }
+  return out.empty() ? "-" : out;
+}
+
+// "format <address> <format> <printf text>" per log line, then "text <text>" and
+// "stream <records>", all but the address as hex
+static void dump()
+{
+  CaptureStream records;
+  console->addSink(records, Console::DEBUG, Console::SINK_RECORDS);
+  logAll();
+  const char *text = "plain output\nafter the records\n";
+  console->print(text);
+  for (const Expected &line : expected)
+    printf("format %08x %s %s\n", (uint32_t)(uintptr_t)line.format, hex(line.format).c_str(), hex(line.text).c_str());
+  printf("text %s\n", hex(text).c_str());
+  printf("stream %s\n", hex(records.bytes).c_str());
+}
+
+int main(int argc, char **argv)
+{
+  Console instance;
+  console = &instance;
+  instance.removeSink(Serial);
+  instance.setDeduplicate(false);
+  instance.setLogLevel(Console::DEBUG);
+
+  if (argc > 1 && strcmp(argv[1], "--dump") == 0)
+  {
+    dump();
+    return 0;
+  }
+
+  encoding();
+  limits();
+  return CHECK_RESULT();
+}
@@ -0,0 +1,140 @@
+// Per sink level filtering of log lines and of the plain print output following them,
+// non-blocking sinks, the per line flush of Serial and lines without the prefix
+#include "Console.h"
+#include "check.h"
+
+#include <string>
+
+class CaptureStream : public Stream
+{
+public:
+  std::string text;
+
+  size_t write(uint8_t c) override { text += (char)c; return 1; }
+  size_t write(const uint8_t *buffer, size_t size) override { text.append((const char *)buffer, size); return size; }
+  using Print::write;
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+};
+
+// availableForWrite() as set by the test, the Print default of 0 until then
+class SpaceStream : public CaptureStream
+{
+public:
+  int space = 0;
+
+  int availableForWrite() override { return space; }
+};
+
+static bool contains(const std::string &text, const char *part)
+{
+  return text.find(part) != std::string::npos;
+}
+
+static void nonBlockingSinks()
+{
+  Console console;
+  console.removeSink(Serial);
+  console.setDeduplicate(false);
+  SpaceStream stream;
+  CHECK(console.addSink(stream, Console::DEBUG, Console::SINK_NONBLOCKING));
+
+  // a stream that never reports space is written blocking, not dropped
+  console.log(Console::INFO, F("no availableForWrite"));
+  CHECK(contains(stream.text, "no availableForWrite"));
+  CHECK(console.getSinkDroppedBytes(stream) == 0);
+
+  // once it reported space, lines that do not fit are dropped whole
+  stream.space = 4096;
+  console.log(Console::INFO, F("room"));
+  stream.space = 10;
+  console.log(Console::INFO, F("longer than ten bytes"));
+  stream.space = 0;
+  console.log(Console::INFO, F("stalled"));
+  CHECK(contains(stream.text, "room"));
+  CHECK(!contains(stream.text, "longer than ten bytes"));
+  CHECK(!contains(stream.text, "stalled"));
+  CHECK(console.getSinkDroppedBytes(stream) > 0);
+}
+
+static void serialFlush()
+{
+  // Serial flushes after each line by default, as before the sink policies
+  Console console;
+  console.setDeduplicate(false);
+  size_t flushes = Serial.flushes;
+  console.log(Console::INFO, F("first"));
+  console.log(Console::INFO, F("second"));
+  CHECK(Serial.flushes == flushes + 2);
+
+  // opt out with SINK_BLOCKING (serial_log_policy 0)
+  CHECK(console.setSinkPolicy(Serial, Console::SINK_BLOCKING));
+  console.log(Console::INFO, F("third"));
+  CHECK(Serial.flushes == flushes + 2);
+}
+
+static void noPrefix()
+{
+  // e.g. syslog, whose header has the time and severity of its own
+  Console console;
+  console.removeSink(Serial);
+  console.setDeduplicate(false);
+  CaptureStream prefixed;
+  CaptureStream bare;
+  CHECK(console.addSink(prefixed, Console::DEBUG));
+  CHECK(console.addSink(bare, Console::DEBUG, Console::SINK_BLOCKING | Console::SINK_NO_PREFIX));
+  console.log(Console::WARNING, F("Battery %d%%"), 15);
+  console.println("plain detail");
+  CHECK(bare.text == "Battery 15%\nplain detail\r\n");
+  CHECK(contains(prefixed.text, " WARNING Battery 15%\n"));
+  CHECK(prefixed.text.size() > bare.text.size());
+}
+
+int main()
+{
+  Console console;
+  console.removeSink(Serial);
+  console.setDeduplicate(false);
+  console.setLogLevel(Console::DEBUG);
+
+  CaptureStream all;      // DEBUG and above
+  CaptureStream warnings; // WARNING and above
+  CaptureStream lowOnly;  // DEBUG and INFO only
+  CHECK(console.addSink(all, Console::DEBUG));
+  CHECK(console.addSink(warnings, Console::WARNING));
+  CHECK(console.addSink(lowOnly, Console::DEBUG));
+  CHECK(console.setSinkMaxLevel(lowOnly, Console::INFO));
+
+  // a DEBUG line followed by a dump, e.g. serializeJsonPretty(doc, console)
+  console.log(Console::DEBUG, F("debug line"));
+  console.print("debug dump");
+  console.println();
+  CHECK(contains(all.text, "debug line"));
+  CHECK(contains(all.text, "debug dump"));
+  CHECK(!contains(warnings.text, "debug line"));
+  CHECK(!contains(warnings.text, "debug dump"));
+  CHECK(contains(lowOnly.text, "debug dump"));
+
+  // plain output after a WARNING line goes to the WARNING sink, not to the capped one
+  console.log(Console::WARNING, F("warning line"));
+  console.println("warning detail");
+  CHECK(contains(all.text, "warning detail"));
+  CHECK(contains(warnings.text, "warning line"));
+  CHECK(contains(warnings.text, "warning detail"));
+  CHECK(!contains(lowOnly.text, "warning line"));
+  CHECK(!contains(lowOnly.text, "warning detail"));
+
+  // raising a sink level applies to the following plain output as well
+  console.log(Console::INFO, F("info line"));
+  CHECK(console.setSinkLevel(all, Console::ERROR));
+  console.println("info detail");
+  CHECK(!contains(all.text, "info detail"));
+  CHECK(contains(lowOnly.text, "info detail"));
+  CHECK(console.getSinkDroppedBytes(all) == 0); // filtered output is not dropped output
+
+  nonBlockingSinks();
+  serialFlush();
+  noPrefix();
+  return CHECK_RESULT();
+}
@@ -0,0 +1,183 @@
+// Eviction order of the HTTP log sink's record buffer: when it is full the oldest
+// record of the lowest level goes first, higher levels are never evicted for lower
+// ones, and the losses are reported at the start of the next batch
+#include "HttpStreamBuffered.h"
+#include "check.h"
+
+#include <string>
+#include <vector>
+
+static const uint8_t LEVELS[] = {10, 20, 30, 40, 50};
+
+struct Line
+{
+  uint8_t level;
+  std::string text;
+};
+
+// 49 byte lines with their level and a sequence number
+static Line makeLine(uint8_t level, unsigned seq)
+{
+  char text[64];
+  snprintf(text, sizeof(text), "L%u #%04u %-38s\n", level, seq, "........");
+  return {level, text};
+}
+
+static size_t write(HttpStreamBuffered &http, const Line &line)
+{
+  return http.writeLeveled(line.level, (const uint8_t *)line.text.data(), line.text.size());
+}
+
+static std::string droppedSummary(const uint32_t *dropped)
+{
+  char text[128];
+  snprintf(text, sizeof(text), "dropped records DEBUG=%u INFO=%u WARNING=%u ERROR=%u CRITICAL=%u\n",
+           dropped[0], dropped[1], dropped[2], dropped[3], dropped[4]);
+  return text;
+}
+
+static void evictionOrder()
+{
+  WiFiClient client;
+  HttpServerStub::reset();
+  HttpStreamBuffered http(client, "test", "http://log.local/log", "/raw", "", "");
+  http.setRaw(true);
+
+  // 30 lines of 52 bytes with header into 1024 bytes: levels cycle, nothing is sent.
+  // A line is stored whole or dropped when only higher levels are left to evict
+  std::vector<Line> lines;
+  for (unsigned seq = 0; seq < 30; seq++)
+  {
+    lines.push_back(makeLine(LEVELS[seq % 5], seq));
+    size_t written = write(http, lines.back());
+    CHECK(written == lines.back().text.size() || (written == 0 && lines.back().level == 10));
+  }
+  CHECK(HttpServerStub::requests.empty());
+
+  http.flush();
+  CHECK(HttpServerStub::requests.size() == 1);
+  if (HttpServerStub::requests.size() != 1)
+    return;
+  const std::string &body = HttpServerStub::requests[0].body;
+
+  // the survivors per level are the newest lines of that level, in their order
+  uint32_t dropped[5] = {};
+  std::string expected;
+  size_t kept = 0;
+  for (size_t i = 0; i < lines.size(); i++)
+  {
+    if (body.find(lines[i].text) != std::string::npos)
+    {
+      expected += lines[i].text;
+      kept++;
+    }
+    else
+      dropped[LogRecordBuffer::levelIndex(lines[i].level)]++;
+  }
+  CHECK(kept == CIRCULAR_BUFFER_SIZE / (lines[0].text.size() + LogRecordBuffer::HEADER_SIZE));
+  CHECK(body == "[HttpStreamBuffered] " + droppedSummary(dropped) + expected);
+  for (uint8_t level = 0; level < 5; level++)
+  {
+    // once a line of a level is kept, all later ones of that level are kept too
+    bool keptBefore = false;
+    for (const Line &line : lines)
+    {
+      if (LogRecordBuffer::levelIndex(line.level) != level)
+        continue;
+      bool keptNow = body.find(line.text) != std::string::npos;
+      CHECK(!keptBefore || keptNow);
+      keptBefore = keptNow;
+    }
+  }
+  // lower levels made room first: no ERROR or CRITICAL line was lost, all DEBUG lines were
+  CHECK(dropped[3] == 0 && dropped[4] == 0);
+  CHECK(dropped[0] == 6);
+  CHECK(dropped[1] > 0 && dropped[1] >= dropped[2]);
+}
+
+static void higherLevelsStay()
+{
+  WiFiClient client;
+  HttpServerStub::reset();
+  HttpStreamBuffered http(client, "test", "http://log.local/log", "/raw", "", "");
+  http.setRaw(true);
+
+  // a buffer full of ERROR lines: DEBUG, INFO and WARNING lines are dropped on arrival
+  for (unsigned seq = 0; seq < 19; seq++)
+    CHECK(write(http, makeLine(40, seq)) > 0);
+  CHECK(write(http, makeLine(10, 100)) == 0);
+  CHECK(write(http, makeLine(20, 101)) == 0);
+  CHECK(write(http, makeLine(30, 102)) == 0);
+  // a CRITICAL line evicts the oldest ERROR line
+  CHECK(write(http, makeLine(50, 103)) > 0);
+
+  http.flush();
+  CHECK(HttpServerStub::requests.size() == 1);
+  if (HttpServerStub::requests.size() != 1)
+    return;
+  const std::string &body = HttpServerStub::requests[0].body;
+  uint32_t dropped[5] = {1, 1, 1, 1, 0};
+  CHECK(body.compare(0, body.find('\n') + 1, "[HttpStreamBuffered] " + droppedSummary(dropped)) == 0);
+  CHECK(body.find(makeLine(40, 0).text) == std::string::npos);
+  CHECK(body.find(makeLine(40, 1).text) != std::string::npos);
+  CHECK(body.find(makeLine(50, 103).text) != std::string::npos);
+}
+
+static void evictionInFlight()
+{
+  WiFiClient client;
+  HttpServerStub::reset();
+  HttpStreamBuffered http(client, "test", "http://log.local/log", "/raw", "", "");
+  http.setRaw(true);
+
+  // a batch of DEBUG and ERROR lines fails to send and stays marked
+  for (unsigned seq = 0; seq < 10; seq++)
+    write(http, makeLine(seq % 2 ? 40 : 10, seq));
+  HttpServerStub::responses.push_back({-1, ""});
+  http.flush();
+  CHECK(HttpServerStub::requests.size() == 1);
+
+  // newer ERROR lines evict the DEBUG lines of the batch in flight
+  for (unsigned seq = 10; seq < 24; seq++)
+    CHECK(write(http, makeLine(40, seq)) > 0);
+
+  HttpServerStub::requests.clear();
+  http.flush();
+  CHECK(HttpServerStub::requests.size() == 2);
+  if (HttpServerStub::requests.size() != 2)
+    return;
+  // the retried batch lost its evicted lines, the next batch reports them
+  const std::string &retried = HttpServerStub::requests[0].body;
+  const std::string &next = HttpServerStub::requests[1].body;
+  CHECK(retried.find("L10 ") == std::string::npos);
+  CHECK(retried.find(makeLine(40, 1).text) == 0);
+  CHECK(retried.find(makeLine(40, 9).text) != std::string::npos);
+  uint32_t dropped[5] = {5, 0, 0, 0, 0};
+  CHECK(next.find("[HttpStreamBuffered] " + droppedSummary(dropped)) == 0);
+  CHECK(next.find(makeLine(40, 23).text) != std::string::npos);
+}
+
+static void truncation()
+{
+  // a record larger than the buffer is cut, write() says how much was kept
+  LogRecordBuffer records(64);
+  std::string large(100, 'x');
+  CHECK(records.write(20, (const uint8_t *)large.data(), large.size()) == 64 - LogRecordBuffer::HEADER_SIZE);
+  CHECK(records.payloadSize() == 64 - LogRecordBuffer::HEADER_SIZE);
+
+  WiFiClient client;
+  HttpServerStub::reset();
+  HttpStreamBuffered http(client, "test", "http://log.local/log", "/raw", "", "");
+  http.setRaw(true);
+  std::string line(2 * CIRCULAR_BUFFER_SIZE, 'y');
+  CHECK(http.writeLeveled(30, (const uint8_t *)line.data(), line.size()) == CIRCULAR_BUFFER_SIZE - LogRecordBuffer::HEADER_SIZE);
+}
+
+int main()
+{
+  evictionOrder();
+  higherLevelsStay();
+  evictionInFlight();
+  truncation();
+  return CHECK_RESULT();
+}
@@ -0,0 +1,114 @@
+// The RTC tail of the HTTP log sink is saved to RTC memory before a reset, not on
+// every write, and the records saved there come back after the reset
+#include "HttpStreamBuffered.h"
+#include "check.h"
+
+#include <LittleFS.h>
+#include <string>
+
+static const uint32_t RTC_OFFSET = 32; // 4 byte blocks
+static const size_t RTC_SIZE = 256;
+
+static void writeLine(HttpStreamBuffered &http, uint8_t level, const char *line)
+{
+  http.writeLeveled(level, (const uint8_t *)line, strlen(line));
+}
+
+static bool posted(const char *part)
+{
+  for (const HttpServerStub::Request &request : HttpServerStub::requests)
+    if (request.body.find(part) != std::string::npos)
+      return true;
+  return false;
+}
+
+int main()
+{
+  WiFiClient client;
+  HttpServerStub::reset();
+
+  {
+    RtcLogBuffer tail(RTC_OFFSET, RTC_SIZE);
+    HttpStreamBuffered http(client, "test", "http://log.local/log", "", "", "");
+    CHECK(http.setRtcTail(&tail) == 0);
+
+    // buffered lines stay in RAM, pieces of a line included
+    uint32_t saves = ESP.rtcWrites;
+    writeLine(http, 20, "first-");
+    writeLine(http, 20, "line\n");
+    writeLine(http, 30, "second-line\n");
+    CHECK(ESP.rtcWrites == saves);
+
+    // suspending before a reset saves them, later lines are saved as they come
+    http.setSuspended(true);
+    CHECK(ESP.rtcWrites > saves);
+    saves = ESP.rtcWrites;
+    writeLine(http, 40, "while-suspended\n");
+    CHECK(ESP.rtcWrites > saves);
+    http.flush();
+    CHECK(HttpServerStub::requests.empty());
+  }
+
+  // reset: the saved records are restored and sent first
+  {
+    RtcLogBuffer tail(RTC_OFFSET, RTC_SIZE);
+    HttpStreamBuffered http(client, "test", "http://log.local/log", "", "", "");
+    CHECK(http.setRtcTail(&tail) == 3);
+    http.flush();
+    CHECK(HttpServerStub::requests.size() == 1);
+    CHECK(posted("first-line"));
+    CHECK(posted("second-line"));
+    CHECK(posted("while-suspended"));
+
+    // an acknowledged batch is removed from RTC memory at once
+    writeLine(http, 20, "acked-line\n");
+    http.flush();
+    writeLine(http, 20, "unsaved-line\n");
+  }
+
+  // reset without a save: neither the acknowledged nor the unsaved line come back
+  {
+    RtcLogBuffer tail(RTC_OFFSET, RTC_SIZE);
+    HttpStreamBuffered http(client, "test", "http://log.local/log", "", "", "");
+    CHECK(http.setRtcTail(&tail) == 0);
+
+    // saveRtcTail() before deep sleep keeps what was not sent
+    writeLine(http, 20, "before-sleep\n");
+    http.saveRtcTail();
+  }
+  {
+    RtcLogBuffer tail(RTC_OFFSET, RTC_SIZE);
+    HttpStreamBuffered http(client, "test", "http://log.local/log", "", "", "");
+    CHECK(http.setRtcTail(&tail) == 1);
+    HttpServerStub::requests.clear();
+    http.flush();
+    CHECK(posted("before-sleep"));
+  }
+
+  // restored records are shipped by the flush after the restore, also behind spilled segments
+  {
+    LittleFS.format();
+    LogSpillQueue queue("/logq", SPILL_SEGMENT_SIZE, 8);
+    CHECK(queue.begin());
+    LogRecordBuffer spilled(SPILL_SEGMENT_SIZE);
+    spilled.write(20, (const uint8_t *)"spilled-line\n", 13);
+    CHECK(queue.spill(spilled, 0));
+
+    RtcLogBuffer saved(RTC_OFFSET, RTC_SIZE);
+    saved.write(30, (const uint8_t *)"restored-line\n", 14);
+    CHECK(saved.save());
+
+    RtcLogBuffer tail(RTC_OFFSET, RTC_SIZE);
+    HttpStreamBuffered http(client, "test", "http://log.local/log", "", "", "");
+    http.setSpillQueue(&queue);
+    CHECK(http.setRtcTail(&tail) == 1);
+    HttpServerStub::requests.clear();
+    http.flush();
+    CHECK(HttpServerStub::requests.size() == 2);
+    CHECK(posted("spilled-line"));
+    CHECK(posted("restored-line"));
+    CHECK(queue.isEmpty());
+  }
+
+  return CHECK_RESULT();
+}
@@ -0,0 +1,74 @@
+// flush() of the HTTP log sink sends the batch in flight, the segments spilled to
+// flash while the server was unreachable and the records in RAM, oldest first
+#include "HttpStreamBuffered.h"
+#include "check.h"
+
+#include <LittleFS.h>
+#include <string>
+
+static const int LINES = 60;
+
+// Position of part in all posted bodies, in request order, npos if missing
+static size_t postedAt(const char *part)
+{
+  std::string bodies;
+  for (const HttpServerStub::Request &request : HttpServerStub::requests)
+    bodies += request.body;
+  return bodies.find(part);
+}
+
+int main()
+{
+  WiFiClient client;
+  HttpServerStub::reset();
+  LittleFS.format();
+
+  LogSpillQueue queue("/logq", SPILL_SEGMENT_SIZE, 8);
+  CHECK(queue.begin());
+  HttpStreamBuffered http(client, "test", "http://log.local/log", "", "", "");
+  http.setSpillQueue(&queue);
+
+  // the server is down: the first batch stays in flight, the overflow is spilled
+  char line[48];
+  HttpServerStub::responses.push_back({HTTPC_ERROR_CONNECTION_FAILED, ""});
+  for (int i = 0; i < LINES; i++)
+  {
+    int length = snprintf(line, sizeof(line), "line-%02d some log text to fill the buffer\n", i);
+    http.writeLeveled(20, (const uint8_t *)line, length);
+    if (i == 0)
+      http.flush();
+  }
+  CHECK(HttpServerStub::requests.size() == 1);
+  CHECK(!queue.isEmpty());
+
+  // back online: one flush sends everything, in the order it was written
+  HttpServerStub::requests.clear();
+  http.flush();
+  CHECK(HttpServerStub::requests.size() >= 3); // batch in flight, spilled segment(s), RAM
+  CHECK(queue.isEmpty());
+  bool inOrder = true;
+  size_t previous = 0;
+  for (int i = 0; i < LINES && inOrder; i++)
+  {
+    snprintf(line, sizeof(line), "line-%02d", i);
+    size_t position = postedAt(line);
+    inOrder = position != std::string::npos && (i == 0 || position > previous);
+    previous = position;
+  }
+  CHECK(inOrder);
+
+  // nothing left to send
+  size_t requests = HttpServerStub::requests.size();
+  http.flush();
+  CHECK(HttpServerStub::requests.size() == requests);
+
+  // a failure ends the flush, the rest waits for the next one
+  http.writeLeveled(20, (const uint8_t *)"after\n", 6);
+  HttpServerStub::responses.push_back({HTTP_CODE_INTERNAL_SERVER_ERROR, ""});
+  http.flush();
+  CHECK(HttpServerStub::requests.size() == requests + 1);
+  http.flush();
+  CHECK(HttpServerStub::requests.size() == requests + 2);
+
+  return CHECK_RESULT();
+}
@@ -0,0 +1,77 @@
+// JSON request bodies of JSONAPIClient POSTs: serialized once to their measured
+// size, below STACK_BODY_SIZE (256) on the stack, from there on with a single
+// heap allocation of the body size plus the terminator
+#include "JSONAPIClient.h"
+#include "check.h"
+
+#include <cstdlib>
+#include <new>
+#include <string>
+
+// Array allocations are counted, the stubs allocate with scalar new only
+static size_t arrayAllocations = 0;
+static size_t arrayBytes = 0;
+
+void *operator new[](size_t size)
+{
+  arrayAllocations++;
+  arrayBytes += size;
+  void *p = malloc(size ? size : 1);
+  if (p == nullptr)
+    throw std::bad_alloc();
+  return p;
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+  arrayAllocations++;
+  arrayBytes += size;
+  return malloc(size ? size : 1);
+}
+
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { free(p); }
+
+// POSTs a body of exactly size bytes: {"text":"xx..."} has 11 bytes around the value
+static void post(size_t size)
+{
+  DynamicJsonDocument requestBody(size + 64);
+  requestBody["text"] = std::string(size - 11, 'x').c_str();
+  CHECK(measureJson(requestBody) == size);
+  DynamicJsonDocument responseBody(64);
+
+  WiFiClient client;
+  PreparedRequest request("http://api.local", "/event");
+  HttpServerStub::reset();
+  arrayAllocations = 0;
+  arrayBytes = 0;
+  int httpCode = JSONAPIClient::performRequest(client, JSONAPIClient::HTTP_METHOD_POST, request, requestBody, responseBody);
+  size_t allocations = arrayAllocations;
+  size_t bytes = arrayBytes;
+
+  CHECK(httpCode == HTTP_CODE_OK);
+  CHECK(HttpServerStub::requests.size() == 1);
+  if (HttpServerStub::requests.size() != 1)
+    return;
+  const HttpServerStub::Request &sent = HttpServerStub::requests[0];
+  CHECK(sent.method == "POST");
+  CHECK(sent.header("Content-Type") == "application/json");
+  CHECK(sent.body == "{\"text\":\"" + std::string(size - 11, 'x') + "\"}");
+
+  bool onStack = size < 256;
+  CHECK(allocations == (onStack ? 0u : 1u));
+  CHECK(bytes == (onStack ? 0 : size + 1));
+  printf("%5zu byte body: %zu allocations, %zu bytes\n", size, allocations, bytes);
+}
+
+int main()
+{
+  post(11);
+  post(100);
+  post(255); // the largest body on the stack, 256 bytes with the terminator
+  post(256);
+  post(1000);
+  post(4096);
+  return CHECK_RESULT();
+}
@@ -0,0 +1,224 @@
+// Lzss output decodes to its input with the decoder of the log server, and the
+// HTTP log sink compresses the raw record payload, not the JSON envelope.
+// "test_lzss --dump" prints input and output of each case as hex for
+// check_lzss_server.py, which decodes them with lzss_decompress() itself.
+#include "HttpStreamBuffered.h"
+#include "Lzss.h"
+#include "check.h"
+
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+typedef std::vector<uint8_t> Bytes;
+
+// lzss_decompress() of ESP8266_server_app.py, line by line
+static Bytes decompress(const Bytes &data)
+{
+  Bytes out;
+  size_t pos = 0;
+  while (pos < data.size())
+  {
+    uint8_t flags = data[pos++];
+    for (int bit = 0; bit < 8; bit++)
+    {
+      if (pos >= data.size())
+        break;
+      if (flags & (1 << bit))
+        out.push_back(data[pos++]);
+      else
+      {
+        if (pos + 2 > data.size())
+          throw std::runtime_error("truncated back reference");
+        uint16_t token = data[pos] | (data[pos + 1] << 8);
+        pos += 2;
+        size_t distance = (token >> 4) + 1;
+        if (distance > out.size())
+          throw std::runtime_error("back reference before start of data");
+        for (int i = 0; i < (token & 0x0F) + 3; i++)
+          out.push_back(out[out.size() - distance]);
+      }
+    }
+  }
+  return out;
+}
+
+static Bytes bytes(const std::string &text) { return Bytes(text.begin(), text.end()); }
+
+static Bytes logText(size_t size)
+{
+  static const char *lines[] = {
+    "12:00:01.250 [INFO] BaseApp: WiFi connected, RSSI -67 dBm\n",
+    "12:00:01.731 [DEBUG] Zoomrec: poll event 42 status 200\n",
+    "12:00:02.004 [WARNING] HttpStreamBuffered: retry in 2000 ms\n",
+  };
+  std::string text;
+  for (unsigned i = 0; text.size() < size; i++)
+    text += lines[(i * 7) % 3];
+  text.resize(size);
+  return bytes(text);
+}
+
+static Bytes randomBytes(size_t size)
+{
+  std::mt19937 random(1);
+  Bytes data(size);
+  for (uint8_t &byte : data)
+    byte = (uint8_t)random();
+  return data;
+}
+
+static std::string hex(const Bytes &data)
+{
+  static const char digits[] = "0123456789abcdef";
+  std::string out;
+  for (uint8_t byte : data)
+  {
+    out += digits[byte >> 4];
+    out += digits[byte & 0x0F];
+  }
+  return out.empty() ? "-" : out;
+}
+
+struct Case
+{
+  const char *name;
+  Bytes input;
+  size_t capacity;
+};
+
+static std::vector<Case> cases()
+{
+  Bytes mixed = logText(3000);
+  Bytes tail = randomBytes(700);
+  mixed.insert(mixed.end(), tail.begin(), tail.end());
+  return {
+    {"empty", Bytes(), 16},
+    {"single byte", bytes("x"), 2},
+    {"long run", Bytes(10000, 'a'), 10000},
+    {"short run", bytes("abababababababababababab"), 24},
+    {"log text", logText(1024), 1024},
+    // larger than the window: matches only reach 4096 bytes back, chain slots are reused
+    {"log text beyond the window", logText(20000), 20000},
+    {"text and random data", mixed, mixed.size()},
+    {"random data, worst case capacity", randomBytes(1000), 1000 + 1000 / 8 + 1},
+  };
+}
+
+static Bytes compress(const Case &test)
+{
+  Bytes out(test.capacity);
+  out.resize(Lzss::compress(test.input.data(), test.input.size(), out.data(), out.size()));
+  return out;
+}
+
+static void roundTrips()
+{
+  for (const Case &test : cases())
+  {
+    Bytes packed = compress(test);
+    if (test.input.empty())
+    {
+      CHECK(packed.empty());
+      continue;
+    }
+    CHECK(!packed.empty());
+    try
+    {
+      Bytes unpacked = decompress(packed);
+      if (unpacked != test.input)
+        fprintf(stderr, "round trip failed: %s\n", test.name);
+      CHECK(unpacked == test.input);
+    }
+    catch (const std::exception &e)
+    {
+      fprintf(stderr, "%s: %s\n", test.name, e.what());
+      CHECK(false);
+    }
+  }
+
+  // a long run takes one literal and a back reference per 18 bytes after it
+  Bytes run(10000, 'a');
+  Bytes packed = compress({"", run, run.size()});
+  CHECK(packed.size() < 10000 / 18 * 2 + 10000 / 18 / 8 + 8);
+
+  // output that does not fit into capacity, e.g. incompressible data, is refused
+  Bytes random = randomBytes(1000);
+  CHECK(compress({"", random, random.size() - 1}).empty());
+  CHECK(compress({"", bytes("x"), 1}).empty());
+
+  // the match finder takes 2 bytes per input byte, at most the window
+  CHECK(Lzss::chainBytes(1024) == 2048);
+  CHECK(Lzss::chainBytes(20000) == 2 * Lzss::WINDOW_SIZE);
+}
+
+static void httpLogBodies()
+{
+  WiFiClient client;
+  const char *line = "12:00:01.250 [INFO] BaseApp: WiFi connected, RSSI -67 dBm\n";
+
+  // raw: the record payload is compressed
+  HttpServerStub::reset();
+  {
+    HttpStreamBuffered http(client, "test", "http://log.local/log", "/raw", "", "");
+    http.setRaw(true);
+    http.setCompress(true);
+    std::string payload;
+    for (int i = 0; i < 10; i++)
+    {
+      http.writeLeveled(20, (const uint8_t *)line, strlen(line));
+      payload += line;
+    }
+    http.flush();
+    CHECK(HttpServerStub::requests.size() == 1);
+    const HttpServerStub::Request &request = HttpServerStub::requests[0];
+    CHECK(request.header("Content-Encoding") == "x-lzss");
+    CHECK(request.body.size() < payload.size() / 2);
+    CHECK(decompress(bytes(request.body)) == bytes(payload));
+    CHECK(http.getCompressSkipped() == 0);
+  }
+
+  // JSON: the envelope is sent as is
+  HttpServerStub::reset();
+  {
+    HttpStreamBuffered http(client, "test", "http://log.local/log", "", "", "");
+    http.setCompress(true);
+    http.writeLeveled(20, (const uint8_t *)line, strlen(line));
+    http.flush();
+    CHECK(HttpServerStub::requests.size() == 1);
+    CHECK(HttpServerStub::requests[0].header("Content-Encoding").empty());
+    CHECK(HttpServerStub::requests[0].body.find("\"content\":") != std::string::npos);
+  }
+
+  // short of heap: sent uncompressed and counted
+  HttpServerStub::reset();
+  {
+    uint32_t freeHeap = ESP.freeHeap;
+    ESP.freeHeap = COMPRESS_HEAP_RESERVE;
+    HttpStreamBuffered http(client, "test", "http://log.local/log", "/raw", "", "");
+    http.setRaw(true);
+    http.setCompress(true);
+    http.writeLeveled(20, (const uint8_t *)line, strlen(line));
+    http.flush();
+    CHECK(HttpServerStub::requests.size() == 1);
+    CHECK(HttpServerStub::requests[0].header("Content-Encoding").empty());
+    CHECK(HttpServerStub::requests[0].body == line);
+    CHECK(http.getCompressSkipped() == 1);
+    ESP.freeHeap = freeHeap;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  if (argc > 1 && strcmp(argv[1], "--dump") == 0)
+  {
+    for (const Case &test : cases())
+      printf("%s %s\n", hex(test.input).c_str(), hex(compress(test)).c_str());
+    return 0;
+  }
+
+  roundTrips();
+  httpLogBodies();
+  return CHECK_RESULT();
+}
@@ -0,0 +1,105 @@
+// Binary records of the TCP log sink are sent whole: a record the send window
+// cannot take waits for room, and after a reconnect the stream behind the new
+// hello line starts at a record boundary
+#include "Console.h"
+#include "TcpLogStream.h"
+#include "check.h"
+
+#include <string>
+
+// A RECORD_TEXT record as written by the console to a record sink
+static std::string textRecord(const std::string &text)
+{
+  std::string record;
+  record += (char)Console::RECORD_TEXT;
+  record += (char)(text.size() & 0xFF);
+  record += (char)(text.size() >> 8);
+  return record + text;
+}
+
+static void write(TcpLogStream &tcp, const std::string &record)
+{
+  tcp.writeLeveled(30, (const uint8_t *)record.data(), record.size());
+}
+
+// The hello line followed by whole RECORD_TEXT records, joined to their text
+static bool parse(const std::string &sent, std::string &text)
+{
+  size_t position = sent.find('\n');
+  if (sent.compare(0, 12, "LOG1 binary ") != 0 || position == std::string::npos)
+    return false;
+  for (position++; position < sent.size();)
+  {
+    if ((uint8_t)sent[position] != Console::RECORD_TEXT || sent.size() - position < Console::RECORD_TEXT_HEADER_SIZE)
+      return false;
+    size_t length = (uint8_t)sent[position + 1] | ((uint8_t)sent[position + 2] << 8);
+    position += Console::RECORD_TEXT_HEADER_SIZE;
+    if (sent.size() - position < length)
+      return false;
+    text += sent.substr(position, length);
+    position += length;
+  }
+  return true;
+}
+
+static void binaryRecords()
+{
+  WiFiClient::connections.clear();
+  TcpLogStream tcp("log.local", 8082, "test", "", "");
+  tcp.setBinary(true);
+  tcp.poll();
+  CHECK(WiFiClient::connections.size() == 1);
+  if (WiFiClient::connections.size() != 1)
+    return;
+  std::shared_ptr<ClientState> first = WiFiClient::connections[0];
+
+  // the send window takes the first record and part of the second: only the first goes
+  std::string one = textRecord("first record\n");
+  std::string two = textRecord(std::string(40, '2') + "\n");
+  std::string three = textRecord("third record\n");
+  first->room = one.size() + 10;
+  write(tcp, one);
+  write(tcp, two);
+  CHECK(first->sent.size() == first->sent.find('\n') + 1 + one.size());
+  CHECK(first->room == 10);
+
+  // the connection breaks: the records it did not take follow the next hello line
+  first->connected = false;
+  write(tcp, three);
+  tcp.poll();
+  CHECK(WiFiClient::connections.size() == 2);
+  if (WiFiClient::connections.size() != 2)
+    return;
+  std::string text;
+  CHECK(parse(first->sent, text) && text == "first record\n");
+  text.clear();
+  CHECK(parse(WiFiClient::connections[1]->sent, text));
+  CHECK(text == std::string(40, '2') + "\nthird record\n");
+}
+
+static void textChunks()
+{
+  WiFiClient::connections.clear();
+  TcpLogStream tcp("log.local", 8082, "test", "", "");
+  tcp.poll();
+  CHECK(WiFiClient::connections.size() == 1);
+  if (WiFiClient::connections.size() != 1)
+    return;
+  std::shared_ptr<ClientState> client = WiFiClient::connections[0];
+  size_t hello = client->sent.size();
+
+  // text has no record boundaries to keep: the window is filled
+  client->room = 10;
+  tcp.print("a line longer than the window\n");
+  CHECK(client->sent.size() == hello + 10);
+  client->room = 100;
+  tcp.poll();
+  CHECK(client->sent.substr(hello) == "a line longer than the window\n");
+}
+
+int main()
+{
+  binaryRecords();
+  textChunks();
+  return CHECK_RESULT();
+}
@@ -0,0 +1,73 @@
+// DEBUG/INFO lines must not push WARNING and above lines out of the telnet ring
+// before every client (or the next one to connect) got them
+#include "TelnetStreamBuffered.h"
+#include "check.h"
+
+#include <string>
+
+class TestTelnet : public TelnetStreamBuffered
+{
+public:
+  using TelnetStreamBuffered::TelnetStreamBuffered;
+
+  std::shared_ptr<ClientState> connect()
+  {
+    std::shared_ptr<ClientState> client = std::make_shared<ClientState>();
+    server.pending.push_back(client);
+    poll();
+    return client;
+  }
+};
+
+static void writeLines(TestTelnet &telnet, uint8_t level, const char *name, int count)
+{
+  char line[48];
+  for (int i = 0; i < count; i++)
+  {
+    int length = snprintf(line, sizeof(line), "%s %03d some log text\n", name, i);
+    telnet.writeLeveled(level, (const uint8_t *)line, length);
+  }
+}
+
+static bool contains(const std::string &text, const char *part)
+{
+  return text.find(part) != std::string::npos;
+}
+
+int main()
+{
+  TestTelnet telnet(23, 512);
+
+  // backlog before the first client connects
+  telnet.writeLeveled(30, (const uint8_t *)"warning before connect\n", 23);
+  writeLines(telnet, 10, "debug", 100);
+  writeLines(telnet, 20, "info", 100);
+  std::shared_ptr<ClientState> client = telnet.connect();
+  CHECK(contains(client->sent, "warning before connect"));
+  CHECK(!contains(client->sent, "debug 099"));
+
+  // the dropped lines are reported before the next line that is kept
+  telnet.println("after connect");
+  CHECK(contains(client->sent, "lines dropped]\r\nafter connect"));
+
+  // a client with a full send window keeps its unsent WARNING line
+  client->room = 0;
+  telnet.writeLeveled(40, (const uint8_t *)"error while stalled\n", 20);
+  writeLines(telnet, 10, "stalled", 100);
+  client->room = 1 << 16;
+  client->sent.clear();
+  telnet.poll();
+  CHECK(contains(client->sent, "error while stalled"));
+  CHECK(!contains(client->sent, "bytes skipped"));
+  telnet.println("after stall");
+  CHECK(contains(client->sent, "lines dropped]\r\nafter stall"));
+
+  // a client that keeps up gets every line, nothing is dropped
+  client->sent.clear();
+  writeLines(telnet, 10, "live", 100);
+  CHECK(contains(client->sent, "live 000"));
+  CHECK(contains(client->sent, "live 099"));
+  CHECK(!contains(client->sent, "dropped"));
+
+  return CHECK_RESULT();
+}